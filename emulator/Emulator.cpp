@@ -33,7 +33,7 @@ int m_wEmulatorCPUBpsCount = 0;
 uint32_t m_EmulatorCPUBps[MAX_BREAKPOINTCOUNT + 1];
 uint32_t m_wEmulatorTempCPUBreakpoint = 0177777;
 int m_wEmulatorWatchesCount = 0;
-uint16_t m_EmulatorWatches[MAX_BREAKPOINTCOUNT];
+uint16_t m_EmulatorWatches[MAX_WATCHESCOUNT];
 
 bool m_okEmulatorSound = false;
 bool m_okEmulatorCovox = false;
@@ -52,6 +52,7 @@ uint8_t* g_pEmulatorChangedRam = nullptr;  // RAM change flags
 uint16_t g_wEmulatorCpuPC = 0;      // Current PC value
 uint16_t g_wEmulatorPrevCpuPC = 0;  // Previous PC value
 
+void Emulator_InitSound();
 void CALLBACK Emulator_SoundGenCallback(unsigned short L, unsigned short R);
 void CALLBACK Emulator_ParallelOut_Callback(BYTE byte);
 
@@ -105,8 +106,6 @@ bool Emulator_Init()
 {
     ASSERT(g_pBoard == nullptr);
 
-    CProcessor::Init();
-
     m_wEmulatorCPUBpsCount = 0;
     for (int i = 0; i <= MAX_BREAKPOINTCOUNT; i++)
     {
@@ -128,7 +127,7 @@ bool Emulator_Init()
 
     if (m_okEmulatorSound)
     {
-        SoundGen_Initialize(Settings_GetSoundVolume());
+        Emulator_InitSound();
         g_pBoard->SetSoundGenCallback(Emulator_SoundGenCallback);
     }
 
@@ -141,8 +140,6 @@ void Emulator_Done()
 {
     ASSERT(g_pBoard != nullptr);
 
-    CProcessor::Done();
-
     g_pBoard->SetSoundGenCallback(nullptr);
     SoundGen_Finalize();
 
@@ -227,6 +224,23 @@ void Emulator_SetTimer64or50(bool value)
     g_pBoard->SetTimer50or64(value);
 }
 
+void Emulator_SetFISNative(bool value, uint16_t timing)
+{
+    if (timing == 0)
+        timing = FIS_NATIVE_TIMING;
+    g_pBoard->GetCPU()->SetFISNative(value, timing);
+}
+
+void Emulator_SetEmulFastPath(bool value)
+{
+    g_pBoard->SetEmulFastPath(value);
+}
+
+void Emulator_SetAccuracy(int accuracy)
+{
+    g_pBoard->SetAccuracy(accuracy);
+}
+
 bool Emulator_AddCPUBreakpoint(uint16_t address, bool ishalt)
 {
     if (m_wEmulatorCPUBpsCount == MAX_BREAKPOINTCOUNT - 1)
@@ -241,7 +255,7 @@ bool Emulator_AddCPUBreakpoint(uint16_t address, bool ishalt)
     {
         if (m_EmulatorCPUBps[i] > bpvalue)  // found the place
         {
-            memcpy(m_EmulatorCPUBps + i + 1, m_EmulatorCPUBps + i, sizeof(uint32_t) * (m_wEmulatorCPUBpsCount - i));
+            memmove(m_EmulatorCPUBps + i + 1, m_EmulatorCPUBps + i, sizeof(uint32_t) * (m_wEmulatorCPUBpsCount - i));
             m_EmulatorCPUBps[i] = bpvalue;
             break;
         }
@@ -252,6 +266,7 @@ bool Emulator_AddCPUBreakpoint(uint16_t address, bool ishalt)
         }
     }
     m_wEmulatorCPUBpsCount++;
+    g_pBoard->SetCPUBreakpoint(address, ishalt);
     return true;
 }
 bool Emulator_RemoveCPUBreakpoint(uint16_t address, bool ishalt)
@@ -269,9 +284,10 @@ bool Emulator_RemoveCPUBreakpoint(uint32_t bpvalue)
         {
             m_EmulatorCPUBps[i] = NOBREAKPOINT;
             m_wEmulatorCPUBpsCount--;
+            g_pBoard->SetCPUBreakpoint(bpvalue & 0xffff, (bpvalue & BREAKPOINT_HALT) != 0, false);
             if (m_wEmulatorCPUBpsCount > i)  // fill the hole
             {
-                memcpy(m_EmulatorCPUBps + i, m_EmulatorCPUBps + i + 1, sizeof(uint32_t) * (m_wEmulatorCPUBpsCount - i));
+                memmove(m_EmulatorCPUBps + i, m_EmulatorCPUBps + i + 1, sizeof(uint32_t) * (m_wEmulatorCPUBpsCount - i));
                 m_EmulatorCPUBps[m_wEmulatorCPUBpsCount] = NOBREAKPOINT;
             }
             return true;
@@ -288,48 +304,30 @@ void Emulator_SetTempCPUBreakpoint(uint16_t address, bool ishalt)
         m_wEmulatorTempCPUBreakpoint = NOBREAKPOINT;
         return;
     }
+    if (g_pBoard->IsCPUBreakpoint(address, ishalt))
+        return;  // We have regular breakpoint with the same address
     uint32_t bpvalue = ((uint32_t)address) | (ishalt ? BREAKPOINT_HALT : 0);
-    for (int i = 0; i < MAX_BREAKPOINTCOUNT; i++)
-    {
-        if (m_EmulatorCPUBps[i] == bpvalue)
-            return;  // We have regular breakpoint with the same address
-    }
     m_wEmulatorTempCPUBreakpoint = bpvalue;
     m_EmulatorCPUBps[m_wEmulatorCPUBpsCount] = bpvalue;
     m_wEmulatorCPUBpsCount++;
+    g_pBoard->SetCPUBreakpoint(address, ishalt);
 }
 const uint32_t* Emulator_GetCPUBreakpointList() { return m_EmulatorCPUBps; }
 bool Emulator_IsBreakpoint()
 {
-    uint16_t address = g_pBoard->GetCPU()->GetPC();
-    uint32_t bpvalue = ((uint32_t)address) | (g_pBoard->GetCPU()->IsHaltMode() ? BREAKPOINT_HALT : 0);
-    if (m_wEmulatorCPUBpsCount > 0)
-    {
-        for (int i = 0; i < m_wEmulatorCPUBpsCount; i++)
-        {
-            if (bpvalue == m_EmulatorCPUBps[i])
-                return true;
-        }
-    }
-    return false;
+    CProcessor* pProc = g_pBoard->GetCPU();
+    return g_pBoard->IsCPUBreakpoint(pProc->GetPC(), pProc->IsHaltMode());
 }
 bool Emulator_IsBreakpoint(uint16_t address, bool ishalt)
 {
-    if (m_wEmulatorCPUBpsCount == 0)
-        return false;
-    uint32_t bpvalue = ((uint32_t)address) | (ishalt ? BREAKPOINT_HALT : 0);
-    for (int i = 0; i < m_wEmulatorCPUBpsCount; i++)
-    {
-        if (bpvalue == m_EmulatorCPUBps[i])
-            return true;
-    }
-    return false;
+    return g_pBoard->IsCPUBreakpoint(address, ishalt);
 }
 void Emulator_RemoveAllBreakpoints()
 {
-    for (int i = 0; i < MAX_BREAKPOINTCOUNT; i++)
+    for (int i = 0; i <= MAX_BREAKPOINTCOUNT; i++)
         m_EmulatorCPUBps[i] = NOBREAKPOINT;
     m_wEmulatorCPUBpsCount = 0;
+    g_pBoard->ClearCPUBreakpoints();
 }
 
 const uint16_t* Emulator_GetWatchList() { return m_EmulatorWatches; }
@@ -342,7 +340,7 @@ bool Emulator_AddWatch(uint16_t address)
         if (m_EmulatorWatches[i] == address)
             return false;  // Already in the list
     }
-    for (int i = 0; i < MAX_BREAKPOINTCOUNT; i++)  // Put in the first empty cell
+    for (int i = 0; i < MAX_WATCHESCOUNT; i++)  // Put in the first empty cell
     {
         if (m_EmulatorWatches[i] == 0177777)
         {
@@ -385,7 +383,7 @@ void Emulator_SetSpeed(uint16_t realspeed)
     uint16_t speedpercent;
     switch (realspeed)
     {
-    case 0: speedpercent = 500; break;
+    case 0: speedpercent = 0; break;  // Maximum, the sound measures the speed
     case 1: speedpercent = 100; break;
     case 2: speedpercent = 200; break;
     case 3: speedpercent = 400; break;
@@ -400,13 +398,23 @@ void Emulator_SetSpeed(uint16_t realspeed)
         SoundGen_SetSpeed(m_wEmulatorSoundSpeed);
 }
 
+// Sound output to the audio device, or to the WAV file given in the command line
+void Emulator_InitSound()
+{
+    SoundGen_SetLatency(Settings_GetSoundLatency());
+    CSoundSink* pSink = nullptr;
+    if (*Option_SoundFile != 0)
+        pSink = SoundGen_CreateFileSink(Option_SoundFile);
+    SoundGen_Initialize(Settings_GetSoundVolume(), pSink);
+}
+
 void Emulator_SetSound(bool soundOnOff)
 {
     if (m_okEmulatorSound != soundOnOff)
     {
         if (soundOnOff)
         {
-            SoundGen_Initialize(Settings_GetSoundVolume());
+            Emulator_InitSound();
             SoundGen_SetSpeed(m_wEmulatorSoundSpeed);
             g_pBoard->SetSoundGenCallback(Emulator_SoundGenCallback);
         }
@@ -464,8 +472,6 @@ void Emulator_UpdateKeyboardMatrix(const uint8_t matrix[8])
 
 bool Emulator_SystemFrame()
 {
-    g_pBoard->SetCPUBreakpoints(m_wEmulatorCPUBpsCount > 0 ? m_EmulatorCPUBps : nullptr);
-
     ScreenView_ScanKeyboard();
     if (Settings_GetMouse())
         ScreenView_UpdateMouse();
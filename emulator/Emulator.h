@@ -17,7 +17,7 @@ NEONBTL. If not, see <http://www.gnu.org/licenses/>. */
 //////////////////////////////////////////////////////////////////////
 
 
-const int MAX_BREAKPOINTCOUNT = 16;
+const int MAX_BREAKPOINTCOUNT = 1024;
 const int MAX_WATCHESCOUNT = 16;
 
 extern CMotherboard* g_pBoard;
@@ -37,6 +37,9 @@ bool Emulator_Init();
 bool Emulator_InitConfiguration(NeonConfiguration configuration);
 void Emulator_Done();
 void Emulator_SetTimer64or50(bool value);
+void Emulator_SetFISNative(bool value, uint16_t timing);
+void Emulator_SetEmulFastPath(bool value);
+void Emulator_SetAccuracy(int accuracy);
 
 bool Emulator_AddCPUBreakpoint(uint16_t address, bool ishalt);
 bool Emulator_RemoveCPUBreakpoint(uint16_t address, bool ishalt);
@@ -48,6 +48,7 @@ LPCTSTR g_CommandLineHelp =
     _T("/nodebug /debugoff\r\n\tSwitch off the debug mode\r\n")
     _T("/sound /soundon\r\n\tTurn sound on\r\n")
     _T("/nosound /soundoff\r\n\tTurn sound off\r\n")
+    _T("/soundfile:filePath\r\n\tWrite sound to WAV file instead of the audio device\r\n")
     _T("/diskN:filePath\r\n\tAttach disk image, N=0..1\r\n")
     _T("/hard:filePath\r\n\tAttach hard disk image\r\n");
 
@@ -132,7 +133,7 @@ int APIENTRY _tWinMain(
             ::DispatchMessage(&msg);
         }
 
-        if (g_okEmulatorRunning && !Settings_GetSound())
+        if (g_okEmulatorRunning)  // The sound does not hold the emulation back, the frame timing does
         {
             WORD speed = Settings_GetRealSpeed();
             if (speed == 0)
@@ -217,6 +218,9 @@ BOOL InitInstance(HINSTANCE /*hInstance*/, int /*nCmdShow*/)
         return FALSE;
 
     Emulator_SetTimer64or50(Settings_GetTimer64or50() != 0);
+    Emulator_SetFISNative(Settings_GetFISNative() != 0, Settings_GetFISNativeTiming());
+    Emulator_SetEmulFastPath(Settings_GetEmulFastPath() != 0);
+    Emulator_SetAccuracy(Settings_GetAccuracy());
     Emulator_SetSound(Settings_GetSound() != 0);
     Emulator_SetCovox(Settings_GetSoundCovox() != 0);
 
@@ -278,6 +282,10 @@ void ParseCommandLine()
         {
             Settings_SetSound(FALSE);
         }
+        else if (_tcslen(arg) > 11 && _tcsncmp(arg, _T("/soundfile:"), 11) == 0)  // "/soundfile:filePath"
+        {
+            _tcsncpy_s(Option_SoundFile, MAX_PATH, arg + 11, _TRUNCATE);
+        }
         else if (_tcslen(arg) > 7 && _tcsncmp(arg, _T("/disk"), 5) == 0)  // "/diskN:filePath", N=0..1
         {
             if (arg[5] >= _T('0') && arg[5] <= _T('1') && arg[6] == ':')
@@ -132,6 +132,14 @@ void Settings_SetConfiguration(int configuration);
 int  Settings_GetConfiguration();
 void Settings_SetTimer64or50(BOOL flag);
 BOOL Settings_GetTimer64or50();
+void Settings_SetFISNative(BOOL flag);
+BOOL Settings_GetFISNative();
+void Settings_SetFISNativeTiming(WORD timing);
+WORD Settings_GetFISNativeTiming();
+void Settings_SetEmulFastPath(BOOL flag);
+BOOL Settings_GetEmulFastPath();
+void Settings_SetAccuracy(int accuracy);
+int  Settings_GetAccuracy();
 void Settings_SetFloppyFilePath(int slot, LPCTSTR sFilePath);
 void Settings_GetFloppyFilePath(int slot, LPTSTR buffer);
 void Settings_SetHardFilePath(LPCTSTR sFilePath);
@@ -164,6 +172,8 @@ void Settings_SetSoundVolume(WORD value);
 WORD Settings_GetSoundVolume();
 void Settings_SetSoundCovox(BOOL flag);
 BOOL Settings_GetSoundCovox();
+void Settings_SetSoundLatency(WORD value);
+WORD Settings_GetSoundLatency();
 void Settings_SetToolbar(BOOL flag);
 BOOL Settings_GetToolbar();
 void Settings_SetKeyboard(BOOL flag);
@@ -181,6 +191,7 @@ void Settings_SetColor(ColorIndices colorIndex, COLORREF color);
 // Options
 
 extern bool Option_ShowHelp;
+extern TCHAR Option_SoundFile[MAX_PATH];  // WAV file to write the sound to instead of the audio device
 
 
 //////////////////////////////////////////////////////////////////////
@@ -24,6 +24,7 @@ TCHAR m_Settings_IniPath[MAX_PATH];
 // Options
 
 bool Option_ShowHelp = false;
+TCHAR Option_SoundFile[MAX_PATH] = { 0 };
 
 
 //////////////////////////////////////////////////////////////////////
@@ -238,6 +239,14 @@ int Settings_GetConfiguration()
 
 SETTINGS_GETSET_DWORD(Timer64or50, _T("Timer64or50"), BOOL, FALSE);
 
+SETTINGS_GETSET_DWORD(FISNative, _T("FISNative"), BOOL, FALSE);
+
+SETTINGS_GETSET_DWORD(FISNativeTiming, _T("FISNativeTiming"), WORD, 0);
+
+SETTINGS_GETSET_DWORD(EmulFastPath, _T("EmulFastPath"), BOOL, FALSE);
+
+SETTINGS_GETSET_DWORD(Accuracy, _T("Accuracy"), int, 0);
+
 void Settings_GetFloppyFilePath(int slot, LPTSTR buffer)
 {
     TCHAR bufValueName[8];
@@ -310,6 +319,7 @@ SETTINGS_GETSET_DWORD(RealSpeed, _T("RealSpeed"), WORD, 1);
 SETTINGS_GETSET_DWORD(Sound, _T("Sound"), BOOL, FALSE);
 SETTINGS_GETSET_DWORD(SoundVolume, _T("SoundVolume"), WORD, 0x3fff);
 SETTINGS_GETSET_DWORD(SoundCovox, _T("SoundCovox"), BOOL, FALSE);
+SETTINGS_GETSET_DWORD(SoundLatency, _T("SoundLatency"), WORD, 120);
 
 SETTINGS_GETSET_DWORD(Keyboard, _T("Keyboard"), BOOL, TRUE);
 
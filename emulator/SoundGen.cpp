@@ -13,89 +13,537 @@ UKNCBTL. If not, see <http://www.gnu.org/licenses/>. */
 #include "stdafx.h"
 #include "SoundGen.h"
 #include "mmsystem.h"
+#include <atomic>
+#include <cmath>
 
 //////////////////////////////////////////////////////////////////////
 
 
-static void CALLBACK waveOutProc(HWAVEOUT, UINT, DWORD, DWORD, DWORD);
+// The ring of sample frames: the emulator thread is the only writer, the audio thread is the only reader.
+// The counters run free, the slot is the counter modulo the ring size.
+static uint32_t m_SoundRing[SOUNDGEN_RINGSIZE];
+static std::atomic<uint32_t> m_SoundRingWritten(0);
+static std::atomic<uint32_t> m_SoundRingRead(0);
+static std::atomic<uint32_t> m_SoundUnderruns(0);
+static std::atomic<uint32_t> m_SoundOverruns(0);
 
-static CRITICAL_SECTION waveCriticalSection;
-static WAVEHDR*         waveBlocks;
-static volatile int     waveFreeBlockCount;
-static int              waveCurrentBlock;
+static CSoundSink*  m_pSoundSink = nullptr;
+static HANDLE       m_hSoundThread = NULL;  // Audio thread of the real time sink; NULL = the emulator thread writes
+static std::atomic<bool> m_okSoundThreadStop(false);
+static int          m_nSoundLatency = SOUNDGEN_LATENCY;
+static int          m_nSoundBlockFrames = 0;
+static uint32_t*    m_pSoundBlock = nullptr;  // Block being written to the sink
 
 static bool m_SoundGenInitialized = false;
 
-HWAVEOUT hWaveOut;
+// Resampler: the emulator gives the samples at the emulation speed, the sink takes them at SOUNDSAMPLERATE.
+// Windowed sinc interpolation, the kernel widens for decimation. The step is the emulation speed, set or
+// measured at the maximum speed, corrected a bit by the control loop keeping the ring fill.
+#define RESAMPLER_ZEROS       8      // Sinc zero crossings on each side
+#define RESAMPLER_TABLESTEPS  256    // Kernel table points per zero crossing
+#define RESAMPLER_MAXSTRETCH  8      // The kernel widens for decimation up to this step, aliasing beyond
+#define RESAMPLER_HISTORY     256    // Input frames kept, power of 2, more than the kernel width
+#define RESAMPLER_CORRECTION  0.005  // Max rate correction of the control loop, 0.5% is not heard
+#define RESAMPLER_MEASURE     500    // Milliseconds to measure the maximum speed
+
+static float    m_ResamplerKernel[RESAMPLER_ZEROS * RESAMPLER_TABLESTEPS + 2];
+static float    m_ResamplerHistory[2][RESAMPLER_HISTORY];  // Input frames: left, right
+static uint32_t m_ResamplerCount = 0;  // Input frames taken
+static double   m_ResamplerNext = 0.0;  // Position of the next output frame, from the last input frame
+static double   m_ResamplerSpeed = 1.0;  // Input frames per output frame, without the correction
+static double   m_ResamplerFill = 0.0;  // Ring fill, smoothed
+static bool     m_okResamplerControl = false;  // Control loop on, for a real time sink
+static WORD     m_wResamplerSpeedPercent = 100;  // Emulation speed set, 0 = maximum
+static bool     m_okResamplerMeasure = false;  // Maximum speed with a real time sink: m_ResamplerSpeed is measured
+static DWORD    m_dwResamplerMeasureStart = 0;  // GetTickCount() of the measure start
+static uint32_t m_ResamplerMeasureCount = 0;  // Input frames since the measure start
 
-WAVEFORMATEX wfx;
-char buffer[BUFSIZE];
 
-int bufcurpos;
+//////////////////////////////////////////////////////////////////////
+// waveOut device sink
+
+class CWaveOutSink : public CSoundSink
+{
+    HWAVEOUT    m_hWaveOut;
+    HANDLE      m_hBlockDone;  // Set by waveOut when a block is played
+    WAVEHDR     m_blocks[SOUNDGEN_BLOCKCOUNT];
+    uint32_t*   m_pData;
+    int         m_blockframes;
+    int         m_current;  // Block to write next
+public:
+    CWaveOutSink() : m_hWaveOut(NULL), m_hBlockDone(NULL), m_pData(nullptr), m_blockframes(0), m_current(0)
+    {
+        ::memset(m_blocks, 0, sizeof(m_blocks));
+    }
+    virtual bool Open(int samplerate, int blockframes);
+    virtual void Close();
+    virtual bool IsRealTime() const { return true; }
+    virtual bool WaitBlock(DWORD timeout);
+    virtual int  GetQueuedBlocks() const;
+    virtual void WriteBlock(const uint32_t* frames, int count);
+    virtual void SetVolume(WORD volume);
+private:
+    bool IsBlockFree(int block) const
+    {
+        DWORD flags = m_blocks[block].dwFlags;
+        return (flags & WHDR_PREPARED) == 0 || (flags & WHDR_DONE) != 0;
+    }
+};
+
+bool CWaveOutSink::Open(int samplerate, int blockframes)
+{
+    m_blockframes = blockframes;
+    m_pData = static_cast<uint32_t*>(::calloc(blockframes * SOUNDGEN_BLOCKCOUNT, sizeof(uint32_t)));
+    if (m_pData == nullptr)
+        return false;
+    for (int i = 0; i < SOUNDGEN_BLOCKCOUNT; i++)
+    {
+        m_blocks[i].lpData = (LPSTR)(m_pData + i * blockframes);
+        m_blocks[i].dwBufferLength = blockframes * 4;
+    }
+    m_current = 0;
+
+    m_hBlockDone = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+
+    WAVEFORMATEX wfx;
+    wfx.nSamplesPerSec  = samplerate;
+    wfx.wBitsPerSample  = 16;
+    wfx.nChannels       = 2;
+    wfx.cbSize          = 0;
+    wfx.wFormatTag      = WAVE_FORMAT_PCM;
+    wfx.nBlockAlign     = (wfx.wBitsPerSample * wfx.nChannels) >> 3;
+    wfx.nAvgBytesPerSec = wfx.nBlockAlign * wfx.nSamplesPerSec;
+
+    MMRESULT result = waveOutOpen(
+            &m_hWaveOut, WAVE_MAPPER, &wfx, (DWORD_PTR)m_hBlockDone, 0, CALLBACK_EVENT);
+    if (result != MMSYSERR_NOERROR)
+    {
+        m_hWaveOut = NULL;
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void CWaveOutSink::Close()
+{
+    if (m_hWaveOut != NULL)
+    {
+        waveOutReset(m_hWaveOut);  // Marks all the blocks done
+        for (int i = 0; i < SOUNDGEN_BLOCKCOUNT; i++)
+        {
+            if (m_blocks[i].dwFlags & WHDR_PREPARED)
+                waveOutUnprepareHeader(m_hWaveOut, &m_blocks[i], sizeof(WAVEHDR));
+        }
+        waveOutClose(m_hWaveOut);
+        m_hWaveOut = NULL;
+    }
+
+    if (m_hBlockDone != NULL)
+    {
+        ::CloseHandle(m_hBlockDone);
+        m_hBlockDone = NULL;
+    }
+
+    ::free(m_pData);
+    m_pData = nullptr;
+}
+
+bool CWaveOutSink::WaitBlock(DWORD timeout)
+{
+    if (IsBlockFree(m_current))
+        return true;
+
+    ::WaitForSingleObject(m_hBlockDone, timeout);
+    return IsBlockFree(m_current);
+}
+
+int CWaveOutSink::GetQueuedBlocks() const
+{
+    int count = 0;
+    for (int i = 0; i < SOUNDGEN_BLOCKCOUNT; i++)
+    {
+        if (!IsBlockFree(i))
+            count++;
+    }
+    return count;
+}
+
+void CWaveOutSink::WriteBlock(const uint32_t* frames, int count)
+{
+    WAVEHDR* current = &m_blocks[m_current];
+
+    if (current->dwFlags & WHDR_PREPARED)
+        waveOutUnprepareHeader(m_hWaveOut, current, sizeof(WAVEHDR));
+
+    memcpy(current->lpData, frames, count * 4);
+    current->dwBufferLength = count * 4;
+
+    waveOutPrepareHeader(m_hWaveOut, current, sizeof(WAVEHDR));
+    waveOutWrite(m_hWaveOut, current, sizeof(WAVEHDR));
+
+    m_current++;
+    if (m_current >= SOUNDGEN_BLOCKCOUNT)
+        m_current = 0;
+}
+
+void CWaveOutSink::SetVolume(WORD volume)
+{
+    waveOutSetVolume(m_hWaveOut, ((DWORD)volume << 16) | ((DWORD)volume));
+}
+
+CSoundSink* SoundGen_CreateWaveOutSink()
+{
+    return new CWaveOutSink();
+}
 
 
 //////////////////////////////////////////////////////////////////////
+// Null sink
 
+class CNullSink : public CSoundSink
+{
+public:
+    virtual bool Open(int /*samplerate*/, int /*blockframes*/) { return true; }
+    virtual void Close() {}
+    virtual bool IsRealTime() const { return false; }
+    virtual bool WaitBlock(DWORD /*timeout*/) { return true; }
+    virtual int  GetQueuedBlocks() const { return 0; }
+    virtual void WriteBlock(const uint32_t* /*frames*/, int /*count*/) {}
+};
+
+CSoundSink* SoundGen_CreateNullSink()
+{
+    return new CNullSink();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+// WAV file sink
+
+class CWavFileSink : public CSoundSink
+{
+    TCHAR       m_sFileName[MAX_PATH];
+    FILE*       m_fpFile;
+    uint32_t    m_datasize;  // Bytes of the samples written
+public:
+    CWavFileSink(LPCTSTR sFileName) : m_fpFile(nullptr), m_datasize(0)
+    {
+        _tcsncpy_s(m_sFileName, MAX_PATH, sFileName, _TRUNCATE);
+    }
+    virtual bool Open(int samplerate, int blockframes);
+    virtual void Close();
+    virtual bool IsRealTime() const { return false; }
+    virtual bool WaitBlock(DWORD /*timeout*/) { return true; }
+    virtual int  GetQueuedBlocks() const { return 0; }
+    virtual void WriteBlock(const uint32_t* frames, int count);
+private:
+    void WriteHeader(int samplerate);
+};
+
+// RIFF header of 16-bit stereo PCM; the sizes are patched on Close()
+void CWavFileSink::WriteHeader(int samplerate)
+{
+    uint8_t header[44];
+    ::memset(header, 0, sizeof(header));
+    memcpy(header + 0, "RIFF", 4);
+    *(uint32_t*)(header + 4) = 36 + m_datasize;
+    memcpy(header + 8, "WAVEfmt ", 8);
+    *(uint32_t*)(header + 16) = 16;  // Format chunk size
+    *(uint16_t*)(header + 20) = WAVE_FORMAT_PCM;
+    *(uint16_t*)(header + 22) = 2;  // Channels
+    *(uint32_t*)(header + 24) = samplerate;
+    *(uint32_t*)(header + 28) = samplerate * 4;  // Bytes per second
+    *(uint16_t*)(header + 32) = 4;  // Block align
+    *(uint16_t*)(header + 34) = 16;  // Bits per sample
+    memcpy(header + 36, "data", 4);
+    *(uint32_t*)(header + 40) = m_datasize;
+    ::fwrite(header, 1, sizeof(header), m_fpFile);
+}
 
-static void CALLBACK WaveCallback(HWAVEOUT /*hwo*/, UINT uMsg, DWORD_PTR dwInstance, DWORD_PTR /*dwParam1*/, DWORD_PTR /*dwParam2*/)
+bool CWavFileSink::Open(int samplerate, int /*blockframes*/)
 {
-    int* freeBlockCounter = (int*)dwInstance;
-    if (uMsg != WOM_DONE)
+    m_fpFile = ::_tfopen(m_sFileName, _T("wb"));
+    if (m_fpFile == nullptr)
+        return false;
+
+    m_datasize = 0;
+    WriteHeader(samplerate);
+    return true;
+}
+
+void CWavFileSink::Close()
+{
+    if (m_fpFile == nullptr)
         return;
 
-    EnterCriticalSection(&waveCriticalSection);
-    (*freeBlockCounter)++;
+    // Rewrite the header with the sizes known now
+    uint8_t header[4];
+    ::fseek(m_fpFile, 4, SEEK_SET);
+    *(uint32_t*)header = 36 + m_datasize;
+    ::fwrite(header, 1, 4, m_fpFile);
+    ::fseek(m_fpFile, 40, SEEK_SET);
+    *(uint32_t*)header = m_datasize;
+    ::fwrite(header, 1, 4, m_fpFile);
+
+    ::fclose(m_fpFile);
+    m_fpFile = nullptr;
+}
 
-    LeaveCriticalSection(&waveCriticalSection);
+void CWavFileSink::WriteBlock(const uint32_t* frames, int count)
+{
+    ::fwrite(frames, 4, count, m_fpFile);
+    m_datasize += count * 4;
 }
 
-void SoundGen_Initialize(WORD volume)
+CSoundSink* SoundGen_CreateFileSink(LPCTSTR sFileName)
 {
-    if (m_SoundGenInitialized)
+    return new CWavFileSink(sFileName);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+
+
+static void SoundGen_InitResampler()
+{
+    const double pi = 3.14159265358979323846;
+    for (int i = 0; i <= RESAMPLER_ZEROS * RESAMPLER_TABLESTEPS; i++)
+    {
+        double x = (double)i / RESAMPLER_TABLESTEPS;
+        double sinc = (i == 0) ? 1.0 : sin(pi * 0.9 * x) / (pi * 0.9 * x);  // Cutoff a bit below Nyquist
+        double window = 0.5 + 0.5 * cos(pi * x / RESAMPLER_ZEROS);  // Hann window
+        m_ResamplerKernel[i] = (float)(sinc * window);
+    }
+    m_ResamplerKernel[RESAMPLER_ZEROS * RESAMPLER_TABLESTEPS + 1] = 0.0f;
+
+    ::memset(m_ResamplerHistory, 0, sizeof(m_ResamplerHistory));
+    m_ResamplerCount = 0;
+    m_ResamplerNext = 0.0;
+    m_ResamplerFill = 0.0;
+    m_dwResamplerMeasureStart = ::GetTickCount();
+    m_ResamplerMeasureCount = 0;
+}
+
+static void SoundGen_RingPut(uint32_t frame)
+{
+    uint32_t written = m_SoundRingWritten.load(std::memory_order_relaxed);
+    if (written - m_SoundRingRead.load(std::memory_order_acquire) >= SOUNDGEN_RINGSIZE)
+    {
+        m_SoundOverruns.fetch_add(1, std::memory_order_relaxed);
         return;
+    }
 
-    unsigned char* mbuffer;
+    m_SoundRing[written & (SOUNDGEN_RINGSIZE - 1)] = frame;
+    m_SoundRingWritten.store(written + 1, std::memory_order_release);
+}
+
+// Input frames per output frame: the speed, corrected by the control loop towards two blocks in the ring
+static double SoundGen_GetResamplerStep()
+{
+    if (!m_okResamplerControl)
+        return m_ResamplerSpeed;
+
+    uint32_t fill = m_SoundRingWritten.load(std::memory_order_relaxed) - m_SoundRingRead.load(std::memory_order_relaxed);
+    m_ResamplerFill += ((double)fill - m_ResamplerFill) / 1024;
+    double target = 2.0 * m_nSoundBlockFrames;
+    double error = (m_ResamplerFill - target) / target;
+    if (error < -1.0) error = -1.0;
+    if (error > 1.0) error = 1.0;
+    return m_ResamplerSpeed * (1.0 + RESAMPLER_CORRECTION * error);
+}
 
-    size_t totalBufferSize = (BLOCK_SIZE + sizeof(WAVEHDR)) * BLOCK_COUNT;
+// The step from the speed set; only a real time sink measures the maximum speed by the clock,
+// the other sinks take it as 100%, so the samples do not depend on the host speed
+static void SoundGen_UpdateSpeed()
+{
+    m_okResamplerMeasure = (m_wResamplerSpeedPercent == 0) &&
+            m_pSoundSink != nullptr && m_pSoundSink->IsRealTime();
+    if (m_wResamplerSpeedPercent > 0)
+        m_ResamplerSpeed = m_wResamplerSpeedPercent / 100.0;
+    else if (!m_okResamplerMeasure)
+        m_ResamplerSpeed = 1.0;
+    m_dwResamplerMeasureStart = ::GetTickCount();
+    m_ResamplerMeasureCount = 0;
+}
 
-    mbuffer = static_cast<unsigned char*>(calloc(totalBufferSize, 1));
-    if (mbuffer == nullptr)
+// Measure the speed at the maximum speed: input frames per second of real time
+static void SoundGen_MeasureSpeed()
+{
+    m_ResamplerMeasureCount++;
+    if ((m_ResamplerMeasureCount & 1023) != 0)
         return;
 
-    waveBlocks = (WAVEHDR*)mbuffer;
-    mbuffer += sizeof(WAVEHDR) * BLOCK_COUNT;
-    for (int i = 0; i < BLOCK_COUNT; i++)
+    DWORD elapsed = ::GetTickCount() - m_dwResamplerMeasureStart;
+    if (elapsed < RESAMPLER_MEASURE)
+        return;
+    if (elapsed < 2 * RESAMPLER_MEASURE)  // Longer means the emulation was stopped, measure again
     {
-        waveBlocks[i].dwBufferLength = BLOCK_SIZE;
-        waveBlocks[i].lpData = (LPSTR)mbuffer;
-        mbuffer += BLOCK_SIZE;
+        double speed = (double)m_ResamplerMeasureCount * 1000 / elapsed / SOUNDSAMPLERATE;
+        m_ResamplerSpeed = (m_ResamplerSpeed + speed) / 2;
     }
+    m_dwResamplerMeasureStart += elapsed;
+    m_ResamplerMeasureCount = 0;
+}
 
-    waveFreeBlockCount = BLOCK_COUNT;
-    waveCurrentBlock   = 0;
+static void SoundGen_Resample(unsigned short L, unsigned short R)
+{
+    uint32_t slot = m_ResamplerCount & (RESAMPLER_HISTORY - 1);
+    m_ResamplerHistory[0][slot] = L;
+    m_ResamplerHistory[1][slot] = R;
+    m_ResamplerCount++;
+    m_ResamplerNext -= 1.0;
 
-    wfx.nSamplesPerSec  = SOUNDSAMPLERATE;
-    wfx.wBitsPerSample  = 16;
-    wfx.nChannels       = 2;
-    wfx.cbSize          = 0;
-    wfx.wFormatTag      = WAVE_FORMAT_PCM;
-    wfx.nBlockAlign     = (wfx.wBitsPerSample * wfx.nChannels) >> 3;
-    wfx.nAvgBytesPerSec = wfx.nBlockAlign * wfx.nSamplesPerSec;
+    for (;;)
+    {
+        double step = SoundGen_GetResamplerStep();
+        double stretch = (step < 1.0) ? 1.0 : ((step > RESAMPLER_MAXSTRETCH) ? RESAMPLER_MAXSTRETCH : step);
+        double halfwidth = RESAMPLER_ZEROS * stretch;
+        if (m_ResamplerNext > -halfwidth)
+            break;  // The kernel needs input frames yet to come
+
+        // Output frame at m_ResamplerNext: the input frames weighted by the kernel, normalized
+        int first = (int)ceil(m_ResamplerNext - halfwidth);
+        int last = (int)floor(m_ResamplerNext + halfwidth);
+        double scale = RESAMPLER_TABLESTEPS / stretch;
+        double suml = 0.0, sumr = 0.0, sumw = 0.0;
+        for (int j = first; j <= last; j++)
+        {
+            double x = fabs(j - m_ResamplerNext) * scale;
+            int index = (int)x;
+            if (index >= RESAMPLER_ZEROS * RESAMPLER_TABLESTEPS)
+                continue;
+            double w = m_ResamplerKernel[index] + (m_ResamplerKernel[index + 1] - m_ResamplerKernel[index]) * (x - index);
+            uint32_t s = (m_ResamplerCount - 1 + j) & (RESAMPLER_HISTORY - 1);
+            suml += w * m_ResamplerHistory[0][s];
+            sumr += w * m_ResamplerHistory[1][s];
+            sumw += w;
+        }
+        int outl = (int)floor(suml / sumw + 0.5);
+        int outr = (int)floor(sumr / sumw + 0.5);
+        outl = (outl < 0) ? 0 : ((outl > 65535) ? 65535 : outl);
+        outr = (outr < 0) ? 0 : ((outr > 65535) ? 65535 : outr);
+        SoundGen_RingPut(((uint32_t)outr << 16) + (uint32_t)outl);
+
+        m_ResamplerNext += step;
+    }
+}
 
-    MMRESULT result = waveOutOpen(
-            &hWaveOut, WAVE_MAPPER, &wfx, (DWORD_PTR)WaveCallback, (DWORD_PTR)&waveFreeBlockCount, CALLBACK_FUNCTION);
-    if (result != MMSYSERR_NOERROR)
+// Move up to count sample frames from the ring to m_pSoundBlock; returns the frames moved
+static uint32_t SoundGen_RingGet(uint32_t count)
+{
+    uint32_t read = m_SoundRingRead.load(std::memory_order_relaxed);
+    uint32_t available = m_SoundRingWritten.load(std::memory_order_acquire) - read;
+    if (count > available)
+        count = available;
+    for (uint32_t i = 0; i < count; i++)
+        m_pSoundBlock[i] = m_SoundRing[(read + i) & (SOUNDGEN_RINGSIZE - 1)];
+    m_SoundRingRead.store(read + count, std::memory_order_release);
+    return count;
+}
+
+// Audio thread of the real time sink: moves the sample frames from the ring to the sink, block by block.
+// The sink waits for the emulator while it has blocks to play; when it runs dry,
+// the block is made up with the last frame, counted as underrun.
+static DWORD WINAPI SoundGen_ThreadProc(LPVOID /*lpParameter*/)
+{
+    const uint32_t blockframes = (uint32_t)m_nSoundBlockFrames;
+
+    while (!m_okSoundThreadStop)
+    {
+        if (!m_pSoundSink->WaitBlock(10))
+            continue;
+
+        uint32_t available = m_SoundRingWritten.load(std::memory_order_acquire) - m_SoundRingRead.load(std::memory_order_relaxed);
+        if (available == 0 || (available < blockframes && m_pSoundSink->GetQueuedBlocks() > 0))
+        {
+            ::Sleep(1);
+            continue;
+        }
+
+        uint32_t count = SoundGen_RingGet(blockframes);
+        uint32_t lastframe = m_pSoundBlock[count - 1];
+        for (uint32_t i = count; i < blockframes; i++)
+            m_pSoundBlock[i] = lastframe;
+        if (count < blockframes)
+            m_SoundUnderruns.fetch_add(blockframes - count, std::memory_order_relaxed);
+
+        m_pSoundSink->WriteBlock(m_pSoundBlock, (int)blockframes);
+    }
+
+    return 0;
+}
+
+// Sink which is not real time: the emulator thread writes every block as soon as it is full,
+// and the partial block at the end
+static void SoundGen_WriteBlocks(bool okPartial)
+{
+    const uint32_t blockframes = (uint32_t)m_nSoundBlockFrames;
+    for (;;)
+    {
+        uint32_t available = m_SoundRingWritten.load(std::memory_order_relaxed) - m_SoundRingRead.load(std::memory_order_relaxed);
+        if (available == 0 || (available < blockframes && !okPartial))
+            break;
+
+        uint32_t count = SoundGen_RingGet(blockframes);
+        m_pSoundSink->WriteBlock(m_pSoundBlock, (int)count);
+    }
+}
+
+void SoundGen_Initialize(WORD volume, CSoundSink* pSink)
+{
+    if (m_SoundGenInitialized)
+    {
+        delete pSink;
+        return;
+    }
+
+    m_nSoundBlockFrames = SOUNDSAMPLERATE * m_nSoundLatency / 1000 / SOUNDGEN_BLOCKCOUNT;
+    m_pSoundBlock = static_cast<uint32_t*>(::calloc(m_nSoundBlockFrames, sizeof(uint32_t)));
+    if (m_pSoundBlock == nullptr)
     {
+        delete pSink;
         return;
     }
 
-    waveOutSetVolume(hWaveOut, ((DWORD)volume << 16) | ((DWORD)volume));
+    if (pSink == nullptr)
+        pSink = SoundGen_CreateWaveOutSink();
+    if (!pSink->Open(SOUNDSAMPLERATE, m_nSoundBlockFrames))
+    {
+        delete pSink;
+        pSink = SoundGen_CreateNullSink();  // No audio device, the emulation goes on the same way
+        pSink->Open(SOUNDSAMPLERATE, m_nSoundBlockFrames);
+    }
+    m_pSoundSink = pSink;
+
+    m_SoundRingWritten = 0;
+    m_SoundRingRead = 0;
+    m_SoundUnderruns = 0;
+    m_SoundOverruns = 0;
+    m_okSoundThreadStop = false;
+    m_hSoundThread = NULL;
+    if (pSink->IsRealTime())
+    {
+        m_hSoundThread = ::CreateThread(NULL, 0, SoundGen_ThreadProc, NULL, 0, NULL);
+        if (m_hSoundThread != NULL)
+            ::SetThreadPriority(m_hSoundThread, THREAD_PRIORITY_ABOVE_NORMAL);
+        else  // Nobody to feed the device, the null sink takes the samples on the emulator thread
+        {
+            pSink->Close();
+            delete pSink;
+            pSink = SoundGen_CreateNullSink();
+            pSink->Open(SOUNDSAMPLERATE, m_nSoundBlockFrames);
+            m_pSoundSink = pSink;
+        }
+    }
+    pSink->SetVolume(volume);
 
-    InitializeCriticalSection(&waveCriticalSection);
-    bufcurpos = 0;
+    SoundGen_InitResampler();
+    m_okResamplerControl = pSink->IsRealTime();
+    SoundGen_UpdateSpeed();
 
     m_SoundGenInitialized = true;
-    //waveOutSetPlaybackRate(hWaveOut,0x00008000);
 }
 
 void SoundGen_Finalize()
@@ -103,22 +551,24 @@ void SoundGen_Finalize()
     if (!m_SoundGenInitialized)
         return;
 
-    while (waveFreeBlockCount < BLOCK_COUNT)
-        Sleep(3);
+    m_SoundGenInitialized = false;
 
-    for (int i = 0; i < waveFreeBlockCount; i++)
+    if (m_hSoundThread != NULL)  // Real time sink stops at once, the frames left in the ring are not heard anyway
     {
-        if (waveBlocks[i].dwFlags & WHDR_PREPARED)
-            waveOutUnprepareHeader(hWaveOut, &waveBlocks[i], sizeof(WAVEHDR));
+        m_okSoundThreadStop = true;
+        ::WaitForSingleObject(m_hSoundThread, INFINITE);
+        ::CloseHandle(m_hSoundThread);
+        m_hSoundThread = NULL;
     }
+    else
+        SoundGen_WriteBlocks(true);  // Everything in the ring, the partial block too, before Close()
 
-    DeleteCriticalSection(&waveCriticalSection);
-    waveOutClose(hWaveOut);
+    m_pSoundSink->Close();
+    delete m_pSoundSink;
+    m_pSoundSink = nullptr;
 
-    ::free(waveBlocks);
-    waveBlocks = nullptr;
-
-    m_SoundGenInitialized = FALSE;
+    ::free(m_pSoundBlock);
+    m_pSoundBlock = nullptr;
 }
 
 void SoundGen_SetVolume(WORD volume)
@@ -126,16 +576,32 @@ void SoundGen_SetVolume(WORD volume)
     if (!m_SoundGenInitialized)
         return;
 
-    waveOutSetVolume(hWaveOut, ((DWORD)volume << 16) | ((DWORD)volume));
+    m_pSoundSink->SetVolume(volume);
 }
 
 void SoundGen_SetSpeed(WORD speedpercent)
 {
-    DWORD dwRate = 0x00010000;
-    if (speedpercent > 0 && speedpercent < 1000)
-        dwRate = (((DWORD)speedpercent / 100) << 16) | ((speedpercent % 100) * 0x00010000 / 100);
+    m_wResamplerSpeedPercent = speedpercent;
+    SoundGen_UpdateSpeed();
+}
+
+void SoundGen_SetLatency(int milliseconds)
+{
+    if (milliseconds < 20)
+        milliseconds = 20;
+    if (milliseconds > 500)  // The ring has to take the latency and a burst of samples
+        milliseconds = 500;
+    m_nSoundLatency = milliseconds;
+}
+
+uint32_t SoundGen_GetUnderrunCount()
+{
+    return m_SoundUnderruns.load(std::memory_order_relaxed);
+}
 
-    waveOutSetPlaybackRate(hWaveOut, dwRate);
+uint32_t SoundGen_GetOverrunCount()
+{
+    return m_SoundOverruns.load(std::memory_order_relaxed);
 }
 
 void CALLBACK SoundGen_FeedDAC(unsigned short L, unsigned short R)
@@ -144,36 +610,11 @@ void CALLBACK SoundGen_FeedDAC(unsigned short L, unsigned short R)
         return;
 
     //DebugLogFormat(_T("FeedDAC %04X\r\n"), L);
-    unsigned int word = ((unsigned int)R << 16) + L;
-    memcpy(&buffer[bufcurpos], &word, 4);
-    bufcurpos += 4;
-
-    if (bufcurpos >= BUFSIZE)
-    {
-        WAVEHDR* current = &waveBlocks[waveCurrentBlock];
-
-        if (current->dwFlags & WHDR_PREPARED)
-            waveOutUnprepareHeader(hWaveOut, current, sizeof(WAVEHDR));
-
-        memcpy(current->lpData, buffer, BUFSIZE);
-        current->dwBufferLength = BLOCK_SIZE;
-
-        waveOutPrepareHeader(hWaveOut, current, sizeof(WAVEHDR));
-        waveOutWrite(hWaveOut, current, sizeof(WAVEHDR));
-
-        EnterCriticalSection(&waveCriticalSection);
-        waveFreeBlockCount--;
-        LeaveCriticalSection(&waveCriticalSection);
-
-        while (!waveFreeBlockCount)
-            Sleep(1);
-
-        waveCurrentBlock++;
-        if (waveCurrentBlock >= BLOCK_COUNT)
-            waveCurrentBlock = 0;
-
-        bufcurpos = 0;
-    }
+    if (m_okResamplerMeasure)
+        SoundGen_MeasureSpeed();
+    SoundGen_Resample(L, R);
+    if (m_hSoundThread == NULL)
+        SoundGen_WriteBlocks(false);
 }
 
 
@@ -17,14 +17,46 @@ UKNCBTL. If not, see <http://www.gnu.org/licenses/>. */
 //////////////////////////////////////////////////////////////////////
 
 
-#define BUFSIZE     ((SOUNDSAMPLERATE / 25) * 4)
-#define BLOCK_COUNT 8
-#define BLOCK_SIZE  BUFSIZE
-
-void SoundGen_Initialize(WORD volume);
+#define SOUNDGEN_RINGSIZE   32768  // Sample frames between the emulator and the audio thread, power of 2
+#define SOUNDGEN_BLOCKCOUNT 4      // Blocks queued in the sink
+#define SOUNDGEN_LATENCY    120    // Default latency, milliseconds, for all the blocks queued
+
+// Sound sink: output of 16-bit stereo sample frames, low word is the left channel.
+// A real time sink is fed by the audio thread; the other sinks get the blocks on the emulator thread,
+// as soon as they are full, so they never lose samples
+class CSoundSink
+{
+public:
+    virtual ~CSoundSink() {}
+    // Start the output at the sample rate, in blocks of blockframes sample frames
+    virtual bool Open(int samplerate, int blockframes) = 0;
+    virtual void Close() = 0;
+    // true = the sink plays in real time and starves without samples, false = it waits for full blocks
+    virtual bool IsRealTime() const = 0;
+    // Wait up to the timeout, milliseconds, for the room for one more block
+    virtual bool WaitBlock(DWORD timeout) = 0;
+    virtual int  GetQueuedBlocks() const = 0;  // Blocks written and not played yet
+    // Write the block; count is less than blockframes for the last block of a sink which is not real time
+    virtual void WriteBlock(const uint32_t* frames, int count) = 0;
+    virtual void SetVolume(WORD /*volume*/) {}
+};
+
+CSoundSink* SoundGen_CreateWaveOutSink();
+CSoundSink* SoundGen_CreateNullSink();  // Drops the samples, for the runs without an audio device
+CSoundSink* SoundGen_CreateFileSink(LPCTSTR sFileName);  // Writes WAV file
+
+// Start the output to the sink, SoundGen owns it from now on; nullptr = waveOut device.
+// The null sink takes over if the sink does not open, or the audio thread does not start.
+void SoundGen_Initialize(WORD volume, CSoundSink* pSink = nullptr);
 void SoundGen_Finalize();
 void SoundGen_SetVolume(WORD volume);
+// Emulation speed, percent, the samples are resampled to play at the emulation pace;
+// 0 = maximum speed, measured for a real time sink, taken as 100% for the others
 void SoundGen_SetSpeed(WORD speedpercent);
+void SoundGen_SetLatency(int milliseconds);  // Applies on the next SoundGen_Initialize()
+uint32_t SoundGen_GetUnderrunCount();  // Sample frames the real time sink played for the lack of samples
+uint32_t SoundGen_GetOverrunCount();  // Sample frames dropped for the full ring, real time sink only
+// Put one sample frame through the resampler to the ring; never waits for the audio thread
 void CALLBACK SoundGen_FeedDAC(unsigned short L, unsigned short R);
 
 
@@ -22,6 +22,9 @@ void TraceInstruction(const CProcessor* pProc, const CMotherboard* pBoard, uint1
 // Macro to printf current instruction address along with H/U flag
 #define HU_INSTRUCTION_PC (m_pCPU->IsHaltMode() ? _T('H') : _T('U')), m_pCPU->GetInstructionPC()
 
+// Sound level of one channel high, the three channels together give 255 * 255
+#define SOUND_CHANNEL_LEVEL  (255 * 255 / 3)
+
 
 //////////////////////////////////////////////////////////////////////
 
@@ -36,6 +39,7 @@ CMotherboard::CMotherboard()
     m_SoundGenCallback = nullptr;
     m_SerialOutCallback = nullptr;
     m_ParallelOutCallback = nullptr;
+    m_CodeWriteCallback = nullptr;
 
     ::memset(m_HR, 0, sizeof(m_HR));
     ::memset(m_UR, 0, sizeof(m_UR));
@@ -45,6 +49,8 @@ CMotherboard::CMotherboard()
     m_pRAM = static_cast<uint8_t*>(::calloc(4096 * 1024, 1));  // 4MB
     m_pROM = static_cast<uint8_t*>(::calloc(16 * 1024, 1));  // 16K
     m_pHDbuff = static_cast<uint8_t*>(::calloc(4 * 512, 1));  // 2K
+    ::memset(m_codepages, 0, sizeof(m_codepages));
+    m_codewrites = m_codeinvalidations = 0;
 
     m_PPIAwr = m_PPIArd = m_PPIBwr = 0;
     m_PPIBrd = 11;  // IHLT EF1 EF0 - инверсные
@@ -64,7 +70,21 @@ CMotherboard::CMotherboard()
     m_keypos = 0;
     m_mousest = m_mousedx = m_mousedy = 0;
 
-    m_rtcticks = 0;
+    m_timer50or64 = false;
+    m_okEmulFastPath = false;
+    m_intchanged = true;
+    m_intupdates = 0;
+    ClearCPUBreakpoints();
+
+    // Schedule periodic events
+    m_usticks = 8;
+    m_timernext = 4;
+    m_events[BOARDEVT_RTC] = 15625 * 8;
+    m_events[BOARDEVT_FRAME50] = 10001 * 8;  // After frametick 10000
+    m_events[BOARDEVT_FDD] = m_events[BOARDEVT_HDD] = BOARDEVT_NEVER;
+    m_events[BOARDEVT_SOUND] = 1000 * 8;
+    m_timerticks = 0;
+    ResetSound();
 
     SetConfiguration(0);  // Default configuration
 
@@ -117,6 +137,8 @@ void CMotherboard::SetConfiguration(uint16_t conf)
 
     m_Configuration = conf;
     m_nRamSizeBytes = nRamSizeKbytes * 1024;
+    UpdateMemoryWindows();
+    UpdateCPUClock();
 
     // Allocate RAM; clean RAM/ROM
     ::memset(m_pROM, 0, 16 * 1024);
@@ -135,6 +157,30 @@ void CMotherboard::SetConfiguration(uint16_t conf)
     //}
 }
 
+void CMotherboard::SetAccuracy(int accuracy)
+{
+    m_pCPU->SetFixedTiming(accuracy == ACCURACY_FUNCTIONAL ? FUNCTIONAL_TIMING : 0);
+}
+
+// CPU clock multiplier changes the CPU ticks per device tick; the pending events keep their real time
+void CMotherboard::UpdateCPUClock()
+{
+    uint32_t multiplier = m_Configuration & NEON_COPT_CPUCLOCK_MASK;
+    uint32_t usticks = (multiplier == 0 ? 1 : multiplier) * 8;
+    if (usticks == m_usticks)
+        return;
+
+    uint64_t ticks = m_pCPU->GetTicks();
+    for (int event = 0; event < BOARDEVT_COUNT; event++)
+    {
+        if (m_events[event] != BOARDEVT_NEVER && m_events[event] > ticks)
+            m_events[event] = ticks + (m_events[event] - ticks) * usticks / m_usticks;
+    }
+    UpdateTimers(ticks);
+    m_timernext = ticks + (m_timernext - ticks) * usticks / m_usticks;
+    m_usticks = usticks;
+}
+
 void CMotherboard::SetTrace(uint32_t dwTrace)
 {
     m_dwTrace = dwTrace;
@@ -171,6 +217,7 @@ void CMotherboard::Reset()
 void CMotherboard::LoadROM(const uint8_t* pBuffer)
 {
     ::memcpy(m_pROM, pBuffer, 16384);
+    m_pCPU->FlushDecoded();
 }
 
 
@@ -252,7 +299,7 @@ bool CMotherboard::IsHardImageReadOnly() const
 
 bool CMotherboard::AttachHardImage(LPCTSTR sFileName)
 {
-    m_pHardDrive = new CHardDrive();
+    m_pHardDrive = new CHardDrive(this);
     bool success = m_pHardDrive->AttachImage(sFileName);
     if (success)
     {
@@ -270,6 +317,7 @@ void CMotherboard::DetachHardImage()
 {
     delete m_pHardDrive;
     m_pHardDrive = nullptr;
+    ScheduleEvent(BOARDEVT_HDD, 0);
 }
 
 uint16_t CMotherboard::GetHardPortWord(uint16_t port)
@@ -300,35 +348,75 @@ uint8_t CMotherboard::GetRAMByte(uint32_t offset) const
 {
     return m_pRAM[offset];
 }
+// All RAM writes go through SetRAMWord/SetRAMByte and their masked variants, or call CheckCodeWrite(),
+// so the CPU decoded instruction cache is kept valid
+void CMotherboard::SetRAMWord(uint32_t offset, uint16_t word)
+{
+    *((uint16_t*)(m_pRAM + offset)) = word;
+    CheckCodeWrite(offset);
+}
 void CMotherboard::SetRAMWord2(uint32_t offset, uint16_t word)
 {
     uint16_t* p = (uint16_t*)(m_pRAM + offset);
-    uint16_t mask =
-        ((word & 0x0003) == 0 ? 0 : 0x0003) | ((word & 0x000C) == 0 ? 0 : 0x000C) |
-        ((word & 0x0030) == 0 ? 0 : 0x0030) | ((word & 0x00C0) == 0 ? 0 : 0x00C0) |
-        ((word & 0x0300) == 0 ? 0 : 0x0300) | ((word & 0x0C00) == 0 ? 0 : 0x0C00) |
-        ((word & 0x3000) == 0 ? 0 : 0x3000) | ((word & 0xC000) == 0 ? 0 : 0xC000);
+    uint16_t mask = (uint16_t)((word | (word >> 1)) & 0x5555);  // Low bit of every non-zero 2-bit pixel
+    mask |= mask << 1;
     *p = (word & mask) | (*p & ~mask);
+    CheckCodeWrite(offset);
 }
 void CMotherboard::SetRAMWord4(uint32_t offset, uint16_t word)
 {
     uint16_t* p = (uint16_t*)(m_pRAM + offset);
-    uint16_t mask =
-        ((word & 0x000F) == 0 ? 0 : 0x000F) | ((word & 0x00F0) == 0 ? 0 : 0x00F0) |
-        ((word & 0x0F00) == 0 ? 0 : 0x0F00) | ((word & 0xF000) == 0 ? 0 : 0xF000);
+    uint16_t mask = (uint16_t)(word | (word >> 1));
+    mask = (uint16_t)((mask | (mask >> 2)) & 0x1111);  // Low bit of every non-zero 4-bit pixel
+    mask *= 15;
     *p = (word & mask) | (*p & ~mask);
+    CheckCodeWrite(offset);
+}
+void CMotherboard::SetRAMByte(uint32_t offset, uint8_t byte)
+{
+    m_pRAM[offset] = byte;
+    CheckCodeWrite(offset);
 }
 void CMotherboard::SetRAMByte2(uint32_t offset, uint8_t byte)
 {
-    uint8_t mask =
-        ((byte & 0x03) == 0 ? 0 : 0x03) | ((byte & 0x0C) == 0 ? 0 : 0x0C) |
-        ((byte & 0x30) == 0 ? 0 : 0x30) | ((byte & 0xC0) == 0 ? 0 : 0xC0);
+    uint8_t mask = (uint8_t)((byte | (byte >> 1)) & 0x55);  // Low bit of every non-zero 2-bit pixel
+    mask |= mask << 1;
     m_pRAM[offset] = (byte & mask) | (m_pRAM[offset] & ~mask);
+    CheckCodeWrite(offset);
 }
 void CMotherboard::SetRAMByte4(uint32_t offset, uint8_t byte)
 {
-    uint8_t mask = ((byte & 0x0F) == 0 ? 0 : 0x0F) | ((byte & 0xF0) == 0 ? 0 : 0xF0);
+    uint8_t mask = (uint8_t)(byte | (byte >> 1));
+    mask = (uint8_t)((mask | (mask >> 2)) & 0x11);  // Low bit of every non-zero 4-bit pixel
+    mask *= 15;
     m_pRAM[offset] = (byte & mask) | (m_pRAM[offset] & ~mask);
+    CheckCodeWrite(offset);
+}
+
+// Write to a code page: drop the decoded instruction, if any, and let the callback know
+void CMotherboard::CodeWrite(uint32_t offset)
+{
+    m_codewrites++;
+    if (m_pCPU->InvalidateDecoded(offset))
+        m_codeinvalidations++;
+    if (m_CodeWriteCallback != nullptr)
+        (*m_CodeWriteCallback)(offset);
+}
+void CMotherboard::ClearCodePages()
+{
+    ::memset(m_codepages, 0, sizeof(m_codepages));
+    m_pCPU->FlushDecoded();
+}
+int CMotherboard::GetCodePageCount() const
+{
+    int count = 0;
+    for (int i = 0; i < CODEPAGE_COUNT / 32; i++)
+    {
+        uint32_t bits = m_codepages[i];
+        for (; bits != 0; bits &= bits - 1)
+            count++;
+    }
+    return count;
 }
 
 uint16_t CMotherboard::GetROMWord(uint16_t offset) const
@@ -372,27 +460,90 @@ void CMotherboard::Tick50()  // 64 Hz / 50 Hz timer
     UpdateInterrupts();
 }
 
-void CMotherboard::TimerTick() // Timer Tick - 2 MHz
+// The PITs are not ticked at 2 MHz but brought up to date when the CPU accesses them or a sound sample is due;
+// all the PIT ticks due at the CPU tick are done, as if every PIT tick was a board event
+void CMotherboard::UpdateTimers(uint64_t ticks)
 {
-    m_snd.SetGate(0, true);
-    m_snd.SetGate(1, true);
-    m_snd.SetGate(2, true);
-    m_snd.Tick();
-
-    m_snl.SetGate(0, m_snd.GetOutput(0));
-    m_snl.SetGate(1, m_snd.GetOutput(1));
-    m_snl.SetGate(2, m_snd.GetOutput(2));
-    m_snl.Tick();
+    if (ticks < m_timernext)
+        return;
+    uint32_t period = m_usticks / 2;
+    uint32_t count = (uint32_t)((ticks - m_timernext) / period + 1);
+    m_timernext += (uint64_t)count * period;
+    AdvanceTimers(count);
+}
+// Timer ticks - 2 MHz; m_snl gates follow m_snd outputs, so every m_snd channel goes up to its output change,
+// then the m_snl channel follows with the gate it had on the way. The channel sound is m_snd output gated
+// by m_snl output, its changes go to the synthesizer with the PIT tick timestamps.
+void CMotherboard::AdvanceTimers(uint32_t nTicks)
+{
+    for (uint8_t chan = 0; chan < 3; chan++)
+    {
+        uint64_t ticks = m_timerticks;
+        m_snd.SetGate(chan, true);
+        for (uint32_t left = nTicks; left > 0; )
+        {
+            bool output = m_snd.GetOutput(chan);
+            uint32_t done = m_snd.Advance(chan, left, true, nullptr);
+            if (done > 1)
+            {
+                m_snl.SetGate(chan, output);
+                // m_snl edges matter only while m_snd output is high
+                for (uint32_t snlleft = done - 1; snlleft > 0; )
+                {
+                    uint32_t snldone = m_snl.Advance(chan, snlleft, output, nullptr);
+                    snlleft -= snldone;
+                    ticks += snldone;
+                    SetSoundLevel(chan, ticks, output && m_snl.GetOutput(chan));
+                }
+            }
+            m_snl.SetGate(chan, m_snd.GetOutput(chan));
+            m_snl.Advance(chan, 1, false, nullptr);
+            ticks++;
+            SetSoundLevel(chan, ticks, m_snd.GetOutput(chan) && m_snl.GetOutput(chan));
+            left -= done;
+        }
+    }
+    m_timerticks += nTicks;
+}
+void CMotherboard::SetSoundLevel(uint8_t chan, uint64_t ticks, bool level)
+{
+    if (level == m_soundlevel[chan])
+        return;
+    m_soundlevel[chan] = level;
+    m_synth.AddDelta(ticks, level ? SOUND_CHANNEL_LEVEL : -SOUND_CHANNEL_LEVEL);
+}
+void CMotherboard::ResetSound()
+{
+    int level = 0;
+    for (uint8_t chan = 0; chan < 3; chan++)
+    {
+        m_soundlevel[chan] = m_snd.GetOutput(chan) && m_snl.GetOutput(chan);
+        if (m_soundlevel[chan])
+            level += SOUND_CHANNEL_LEVEL;
+    }
+    m_synth.Reset(m_timerticks, level);
+}
+void CMotherboard::SetSoundSampleRate(int samplerate)
+{
+    UpdateTimers(m_pCPU->GetTicks());
+    m_synth.SetSampleRate(samplerate);
+    ResetSound();
 }
 // address = 0161010..0161026
 void CMotherboard::ProcessTimerWrite(uint16_t address, uint8_t byte)
 {
+    UpdateTimers(m_pCPU->GetTicks());
     PIT8253& pit = (address & 020) != 0 ? m_snl : m_snd;
     pit.Write((address >> 1) & 3, byte);
+
+    // Control word sets the output at once, not on a PIT tick
+    for (uint8_t chan = 0; chan < 3; chan++)
+        SetSoundLevel(chan, m_timerticks, m_snd.GetOutput(chan) && m_snl.GetOutput(chan));
 }
 // address = 0161010..0161026
 uint8_t CMotherboard::ProcessTimerRead(uint16_t address)
 {
+    UpdateTimers(m_pCPU->GetTicks());
     PIT8253& pit = (address & 020) != 0 ? m_snl : m_snd;
     return pit.Read((address >> 1) & 3);
 }
@@ -411,9 +562,11 @@ void CMotherboard::ProcessKeyboardWrite(uint8_t byte)
     case 0xc0:  // Clear command
         m_keypos = 0;
         m_keyint = false;
+        InterruptChanged();
         break;
     case 0xe0:  // End interrupt command
         m_keyint = false;
+        InterruptChanged();
         break;
     }
 }
@@ -433,7 +586,10 @@ void CMotherboard::UpdateKeyboardMatrix(const uint8_t matrix[8])
     ::memcpy(m_keymatrix, matrix, sizeof(m_keymatrix));
 
     if (hasChanges && !m_keyint)
+    {
         m_keyint = true;
+        UpdateInterrupts();  // Called from outside of an instruction, no InstructionDone() to update
+    }
 }
 
 void CMotherboard::ProcessMouseWrite(uint8_t byte)
@@ -471,6 +627,7 @@ void CMotherboard::MouseMove(short dx, short dy, bool btnLeft, bool btnRight)
     m_mousedy = (signed char)(-dy);
 
     m_PPIArd = (m_PPIArd & ~0xe0) | (btnLeft ? 0 : 0x20) | (btnRight ? 0 : 0x40);
+    UpdateInterrupts();
 }
 
 void CMotherboard::DebugTicks()
@@ -485,88 +642,38 @@ void CMotherboard::DebugTicks()
     m_pCPU->Execute();
 
     UpdateInterrupts();
-
-    m_pFloppyCtl->Periodic();
 }
 
 /*
 Каждый фрейм равен 1/25 секунды = 40 мс = 40000 тиков, 1 тик = 1 мкс.
 В каждый фрейм происходит:
-* 320000 тиков ЦП - 8 раз за тик - 8 МГц
+* 320000 тиков ЦП - 8 раз за тик - 8 МГц, умножается на CPU clock multiplier
 * программируемый таймер - на каждый 4-й тик процессора - 2 МГц
 * 2 тика 50 Гц
 * 2.56 тика 64 Гц
-* 625 тиков FDD - каждый 64-й тик (300 RPM = 5 оборотов в секунду)
-* 882 тиков звука (для частоты 22050 Гц)
+* 40 выдач звука по 1 мс, всего 1764 сэмпла (для частоты 44100 Гц)
+Devices schedule their events in m_events, the CPU runs whole instructions between the events;
+the PIT ticks are not events, the PITs catch up when accessed, see UpdateTimers().
 */
 bool CMotherboard::SystemFrame()
 {
-    const int soundSamplesPerFrame = SOUNDSAMPLERATE / 25;
-    int soundBrasErr = 0;
-    int snl0 = 0, snl1 = 0, snl2 = 0, soundTicks = 0, snd0 = 0, snd1 = 0, snd2 = 0;
+    uint64_t frameend = m_pCPU->GetTicks() + 40000 * m_usticks;
+    UpdateTimers(m_pCPU->GetTicks());
+    m_codewrites = m_codeinvalidations = 0;
+    m_intupdates = 0;
+    UpdateInterrupts();  // Changes made between the frames, like a key pressed
 
-    for (int frameticks = 0; frameticks < 40000; frameticks++)
+    for (;;)
     {
-        for (int procticks = 0; procticks < 8; procticks++)  // CPU ticks
+        // Process all the events due now, and find the nearest event
+        uint64_t ticks = m_pCPU->GetTicks();
+        uint64_t next = frameend;
+        for (int event = 0; event < BOARDEVT_COUNT; event++)
         {
-#if !defined(PRODUCT)
-            if ((m_dwTrace & TRACE_CPU) != 0 && m_pCPU->GetInternalTick() == 0)
-                TraceInstruction(m_pCPU, this, m_pCPU->GetPC() & ~1);
-#endif
-
-            m_pCPU->Execute();
-
-            UpdateInterrupts();
-
-            if (m_CPUbps != nullptr)  // Check for breakpoints
-            {
-                uint32_t cpucurrent = (m_pCPU->GetPC() & 0xffff) | (m_pCPU->IsHaltMode() ? BREAKPOINT_HALT : 0);
-                const uint32_t* pbps = m_CPUbps;
-                while (*pbps != NOBREAKPOINT) { if (cpucurrent == *pbps++) return false; }
-            }
-
-            if ((procticks & 3) == 3)  // Every 4th tick
-            {
-                TimerTick();
-                snd0 += m_snd.GetOutput(0) ? 1 : 0;
-                snd1 += m_snd.GetOutput(1) ? 1 : 0;
-                snd2 += m_snd.GetOutput(2) ? 1 : 0;
-                snl0 += m_snl.GetOutput(0) ? 1 : 0;
-                snl1 += m_snl.GetOutput(1) ? 1 : 0;
-                snl2 += m_snl.GetOutput(2) ? 1 : 0;
-                soundTicks++;
-            }
-        }
-
-        m_rtcticks++;
-        if (m_timer50or64)
-        {
-            if (frameticks % 20000 == 10000)  // 50 Hz
-                Tick50();
-        }
-        else
-        {
-            if (m_rtcticks >= 15625)  // 64 Hz RTC tick
-                Tick50();
-        }
-        if (m_rtcticks >= 15625) m_rtcticks = 0;
-
-        if (frameticks % 64 == 0)  // FDD tick
-            m_pFloppyCtl->Periodic();
-
-        if (m_pHardDrive != nullptr)
-            m_pHardDrive->Periodic();
-
-        soundBrasErr += soundSamplesPerFrame;
-        if (2 * soundBrasErr >= 40000)
-        {
-            soundBrasErr -= 40000;
-            //DebugLogFormat(_T("SoundSNL %02d  %2d %2d %2d  %2d %2d %2d\r\n"), soundTicks, snd0, snd1, snd2, snl0, snl1, snl2);
-            uint16_t s0 = (uint16_t)((snd0 * 255 / soundTicks) * (snl0 * 255 / soundTicks));
-            uint16_t s1 = (uint16_t)((snd1 * 255 / soundTicks) * (snl1 * 255 / soundTicks));
-            uint16_t s2 = (uint16_t)((snd2 * 255 / soundTicks) * (snl1 * 255 / soundTicks));
-            DoSound(s0, s1, s2);
-            soundTicks = 0; snl0 = snl1 = snl2 = 0; snd0 = snd1 = snd2 = 0;
+            if (m_events[event] <= ticks)
+                ProcessEvent(event);
+            if (m_events[event] < next)
+                next = m_events[event];
         }
 
         //if (m_ParallelOutCallback != nullptr)
@@ -586,11 +693,102 @@ bool CMotherboard::SystemFrame()
         //        // Now the printer waits for Strobe
         //    }
         //}
+
+        if (ticks >= frameend)
+            break;
+
+        if (!m_pCPU->RunUntil(next))
+            return false;  // Breakpoint hit
+    }
+
+    return true;
+}
+
+void CMotherboard::ProcessEvent(int event)
+{
+    uint64_t ticks = m_events[event];
+    switch (event)
+    {
+    case BOARDEVT_RTC:
+        if (!m_timer50or64)  // 64 Hz RTC tick
+            Tick50();
+        m_events[event] = ticks + 15625 * m_usticks;
+        break;
+    case BOARDEVT_FRAME50:
+        if (m_timer50or64)  // 50 Hz
+            Tick50();
+        m_events[event] = ticks + 20000 * m_usticks;
+        break;
+    case BOARDEVT_FDD:
+        m_events[event] = BOARDEVT_NEVER;
+        m_pFloppyCtl->FlushTimeout();
+        break;
+    case BOARDEVT_HDD:
+        m_events[event] = BOARDEVT_NEVER;
+        if (m_pHardDrive != nullptr)
+            m_pHardDrive->ProcessTimeout();
+        break;
+    case BOARDEVT_SOUND:
+        UpdateTimers(ticks);
+        DoSound();
+        m_events[event] = ticks + 1000 * m_usticks;
+        break;
+    }
+}
+
+void CMotherboard::ScheduleEvent(int event, uint32_t timeout)
+{
+    if (timeout == 0)
+    {
+        m_events[event] = BOARDEVT_NEVER;
+        return;
     }
 
+    uint64_t ticks = (m_pCPU->GetTicks() / m_usticks + timeout) * m_usticks;  // Devices count 1 us ticks
+    m_events[event] = ticks;
+    m_pCPU->LimitRun(ticks);
+}
+
+uint64_t CMotherboard::GetDeviceTime() const
+{
+    return m_pCPU->GetTicks() / m_usticks;
+}
+
+// Interrupt lines and breakpoints can change only when the CPU executes something,
+// so there's no need to check them on the ticks spent inside an instruction
+bool CMotherboard::InstructionDone()
+{
+    if (m_intchanged)
+        UpdateInterrupts();
+
+    if (m_CPUbpcount > 0 && IsCPUBreakpoint(m_pCPU->GetPC(), m_pCPU->IsHaltMode()))
+        return false;  // Breakpoint hit
+
     return true;
 }
 
+void CMotherboard::SetCPUBreakpoint(uint16_t address, bool ishalt, bool set)
+{
+    uint32_t* pword = &m_CPUbpmap[ishalt ? 1 : 0][address >> 5];
+    uint32_t mask = 1u << (address & 31);
+    if (((*pword & mask) != 0) == set)
+        return;  // Already in this state
+    if (set)
+    {
+        *pword |= mask;  m_CPUbpcount++;
+    }
+    else
+    {
+        *pword &= ~mask;  m_CPUbpcount--;
+    }
+}
+
+void CMotherboard::ClearCPUBreakpoints()
+{
+    ::memset(m_CPUbpmap, 0, sizeof(m_CPUbpmap));
+    m_CPUbpcount = 0;
+}
+
 
 //////////////////////////////////////////////////////////////////////
 // Motherboard: memory management
@@ -655,7 +853,7 @@ uint32_t CMotherboard::GetRAMFullAddress(uint16_t address, bool okHaltMode) cons
     return ((uint32_t)(address & 017777)) + (((uint32_t)(memreg & 037760)) << 8);
 }
 
-uint16_t CMotherboard::GetWord(uint16_t address, bool okHaltMode, bool okExec)
+uint16_t CMotherboard::GetWord(uint16_t address, bool okHaltMode, bool okExec, bool isRMW)
 {
     uint32_t offset;
     int addrtype = TranslateAddress(address, okHaltMode, okExec, &offset);
@@ -666,6 +864,8 @@ uint16_t CMotherboard::GetWord(uint16_t address, bool okHaltMode, bool okExec)
     case ADDRTYPE_RAM:
     case ADDRTYPE_RAM2:
     case ADDRTYPE_RAM4:
+        if (okExec)
+            MarkCodePage(offset);
         return GetRAMWord(offset & ~1);
     case ADDRTYPE_ROM:
         return GetROMWord(offset & 0xfffe);
@@ -673,12 +873,15 @@ uint16_t CMotherboard::GetWord(uint16_t address, bool okHaltMode, bool okExec)
         //TODO: What to do if okExec == true ?
         return GetPortWord(address);
     case ADDRTYPE_EMUL:
+        if (m_okEmulFastPath && !okExec && !isRMW && ProcessEmulReadFast(address))
+            return GetRAMWord(offset & 07776);
         if ((m_PPIBrd & 1) == 1)  // EF0 inactive?
             m_HR[0] = address;
         else
             m_HR[1] = address;
         m_PPIBrd &= ~1;  // set EF0 active
         m_pCPU->SetHALTPin(true);
+        InterruptChanged();
         res = GetRAMWord(offset & 07776);
         DebugLogFormat(_T("%c%06ho\tGETWORD %06ho EMUL -> %06ho\n"), HU_INSTRUCTION_PC, address, res);
         return res;
@@ -694,7 +897,7 @@ uint16_t CMotherboard::GetWord(uint16_t address, bool okHaltMode, bool okExec)
     return 0;
 }
 
-uint8_t CMotherboard::GetByte(uint16_t address, bool okHaltMode)
+uint8_t CMotherboard::GetByte(uint16_t address, bool okHaltMode, bool isRMW)
 {
     uint32_t offset;
     int addrtype = TranslateAddress(address, okHaltMode, false, &offset);
@@ -712,12 +915,15 @@ uint8_t CMotherboard::GetByte(uint16_t address, bool okHaltMode)
         //TODO: What to do if okExec == true ?
         return GetPortByte(address);
     case ADDRTYPE_EMUL:
+        if (m_okEmulFastPath && !isRMW && ProcessEmulReadFast(address))
+            return GetRAMByte(offset & 07777);
         if ((m_PPIBrd & 1) == 1)  // EF0 inactive?
             m_HR[0] = address;
         else
             m_HR[1] = address;
         m_PPIBrd &= ~1;  // set EF0 active
         m_pCPU->SetHALTPin(true);
+        InterruptChanged();
         resb = GetRAMByte(offset & 07777);
         DebugLogFormat(_T("%c%06ho\tGETBYTE %06ho EMUL %03ho\n"), HU_INSTRUCTION_PC, address, resb);
         return resb;
@@ -770,6 +976,7 @@ void CMotherboard::SetWord(uint16_t address, bool okHaltMode, uint16_t word, boo
         }
         m_PPIBrd &= ~3;  // set EF1,EF0 active
         m_pCPU->SetHALTPin(true);
+        InterruptChanged();
         return;
     case ADDRTYPE_NULL:
         return;
@@ -817,6 +1024,7 @@ void CMotherboard::SetByte(uint16_t address, bool okHaltMode, uint8_t byte, bool
         }
         m_PPIBrd &= ~3;  // set EF1,EF0 active
         m_pCPU->SetHALTPin(true);
+        InterruptChanged();
         return;
     case ADDRTYPE_NULL:
         return;
@@ -829,7 +1037,47 @@ void CMotherboard::SetByte(uint16_t address, bool okHaltMode, uint8_t byte, bool
     ASSERT(false);  // If we are here - then addrtype has invalid value
 }
 
-int CMotherboard::TranslateAddress(uint16_t address, bool okHaltMode, bool /*okExec*/, uint32_t* pOffset) const
+// Translate the first and the last address of the window; if both give the same type and the offsets
+// are contiguous, every address in between translates the same way
+void CMotherboard::UpdateMemoryWindow(bool okHaltMode, int window)
+{
+    MemoryWindow& entry = m_windows[okHaltMode ? 1 : 0][window];
+    uint16_t address = (uint16_t)(window << 13);
+    uint32_t offset, offsetlast;
+    int addrtype = TranslateAddressSlow(address, okHaltMode, &offset);
+    int addrtypelast = TranslateAddressSlow(address + 017777, okHaltMode, &offsetlast);
+    entry.offset = offset;
+    entry.addrtype = (addrtype == addrtypelast && offsetlast == offset + 017777) ? addrtype : -1;
+
+    const uint8_t*& pread = m_readmap[okHaltMode ? 1 : 0][window];
+    uint8_t*& pwrite = m_writemap[okHaltMode ? 1 : 0][window];
+    pread = pwrite = nullptr;
+    switch (entry.addrtype)
+    {
+    case ADDRTYPE_RAM:
+        pwrite = m_pRAM + offset;
+        pread = pwrite;
+        break;
+    case ADDRTYPE_RAM2:
+    case ADDRTYPE_RAM4:
+        pread = m_pRAM + offset;
+        break;
+    case ADDRTYPE_ROM:
+        pread = m_pROM + offset;
+        break;
+    }
+}
+// HALT mode windows 0 and 1 are ROM always, so the HR0/HR1 writes on EMUL access need no update
+void CMotherboard::UpdateMemoryWindows()
+{
+    for (int window = 0; window < 8; window++)
+    {
+        UpdateMemoryWindow(false, window);
+        UpdateMemoryWindow(true, window);
+    }
+}
+
+int CMotherboard::TranslateAddressSlow(uint16_t address, bool okHaltMode, uint32_t* pOffset) const
 {
     if (okHaltMode && address < 040000)
     {
@@ -890,6 +1138,33 @@ int CMotherboard::TranslateAddress(uint16_t address, bool okHaltMode, bool /*okE
     return (maskmode & 2) == 0 ? ADDRTYPE_RAM2 : ADDRTYPE_RAM4;
 }
 
+// USER read of the emulated register without the HALT mode round trip, if the ROM has nothing to do on it.
+// The ROM keeps a descriptor word for every emulated register at HALT address (register - 020000):
+//   0 = no such register, bus error;
+//   > 0 = write handler address, nothing to do on read;
+//   < 0 = address of the register block; the ROM puts 010 (read) or 014 (write) to the access byte
+//         at +4 and calls the handler if the access byte matches the mask byte at +5.
+// The register value is already in the register window, so it is enough to repeat the access byte update.
+// Returns false if the access should go the usual way.
+bool CMotherboard::ProcessEmulReadFast(uint16_t address)
+{
+    uint32_t offset;
+    int addrtype = TranslateAddress((address & ~1) - 020000, true, false, &offset);
+    if (addrtype != ADDRTYPE_RAM && addrtype != ADDRTYPE_RAM2 && addrtype != ADDRTYPE_RAM4)
+        return false;
+    uint16_t descriptor = GetRAMWord(offset & ~1);
+    if (descriptor == 0)
+        return false;
+    if ((descriptor & 0100000) == 0)
+        return true;
+
+    addrtype = TranslateAddress(descriptor + 4, true, false, &offset);
+    if (addrtype != ADDRTYPE_RAM && addrtype != ADDRTYPE_RAM2 && addrtype != ADDRTYPE_RAM4)
+        return false;
+    SetByte(descriptor + 4, true, 010);
+    return (GetByte(descriptor + 5, true) & 010) == 0;
+}
+
 uint8_t CMotherboard::GetPortByte(uint16_t address)
 {
     if (address & 1)
@@ -977,6 +1252,7 @@ uint16_t CMotherboard::GetPortWord(uint16_t address)
         DebugLogFormat(_T("%c%06ho\tGETPORT %06ho HD.CSR\n"), HU_INSTRUCTION_PC, address);
         m_HDbuffdir = false;  // Обращение к HD.CSR переводит буфер в режим чтения
         m_hdint = false;
+        InterruptChanged();
         return 0x41;
 
     case 0161060:  // DLBUF
@@ -1124,6 +1400,32 @@ uint16_t CMotherboard::GetPortView(uint16_t address) const
     }
 }
 
+bool CMotherboard::IsReadStable(uint16_t address, bool okHaltMode) const
+{
+    uint32_t offset;
+    switch (TranslateAddress(address, okHaltMode, false, &offset))
+    {
+    case ADDRTYPE_RAM:
+    case ADDRTYPE_RAM2:
+    case ADDRTYPE_RAM4:
+    case ADDRTYPE_ROM:
+    case ADDRTYPE_NULL:
+        return true;
+    case ADDRTYPE_IO:
+        switch (address & 0xfffe)
+        {
+        case 0161030: case 0161032: case 0161034:  // PPIA, PPIB, PPIC
+        case 0161042: case 0161044: case 0161046: case 0161050: case 0161052:  // HD registers except BUFF, SDH, CSR
+        case 0161060: case 0161062: case 0161066:  // DLBUF, DLCSR, KBDBUF
+        case 0161070: case 0161076:  // FD.CSR, FD.CNT
+        case 0161122: case 0161124: case 0161126: case 0161130: case 0161132: case 0161134: case 0161136:  // IDE except data
+            return true;
+        }
+        return address >= 0161200 && address < 0161240;  // HR, UR
+    }
+    return false;  // EMUL goes through HALT mode, DENY makes bus error
+}
+
 void CMotherboard::SetPortByte(uint16_t address, uint8_t byte)
 {
     uint16_t word;
@@ -1213,6 +1515,7 @@ void CMotherboard::SetPortWord(uint16_t address, uint16_t word)
 #endif
         m_PPIC = word & 0xff;
         m_PPIBrd = (m_PPIBrd & ~8) | ((m_PPIC & 4) == 0 ? 0 : 8);  // PC2(IHLT) -> PB3
+        InterruptChanged();
         m_pCPU->SetVIRQ((m_PPIC & 010) == 0);
         break;
     case 0161036:  // PPIP -- Parallel port mode control
@@ -1263,7 +1566,10 @@ void CMotherboard::SetPortWord(uint16_t address, uint16_t word)
         m_HDbuffdir = false;  // Обращение к HD.CSR переводит буфер в режим чтения
         //NOTE: Контроллер винчестера не реализован, но он должен отдать сигнал на прерывание в ответ на команду RESTORE
         if (word == 020)  // RESTORE
+        {
             m_hdint = true;
+            InterruptChanged();
+        }
         break;
 
     case 0161060:  // DLBUF
@@ -1309,8 +1615,12 @@ void CMotherboard::SetPortWord(uint16_t address, uint16_t word)
                 m_pCPU->MemoryError();  // Запись HR в режиме USER запрещена
             int chunk = (address >> 1) & 7;
             m_HR[chunk] = word;
+            UpdateMemoryWindow(true, chunk);
             if (m_pCPU->IsHaltMode() && (chunk == 0 || chunk == 1))  // Запись HR0 или HR1 в режиме HALT
+            {
                 m_PPIBrd |= 3;  // Снимаем EF0 и EF1
+                InterruptChanged();
+            }
             break;
         }
 
@@ -1320,6 +1630,7 @@ void CMotherboard::SetPortWord(uint16_t address, uint16_t word)
             DebugLogFormat(_T("%c%06ho\tSETPORT UR %06ho -> (%06ho)\n"), HU_INSTRUCTION_PC, word, address);
             int chunk = (address >> 1) & 7;
             m_UR[chunk] = word;
+            UpdateMemoryWindow(false, chunk);
             break;
         }
 
@@ -1346,6 +1657,7 @@ void CMotherboard::SetPortWord(uint16_t address, uint16_t word)
 
 void CMotherboard::ProcessPICWrite(bool a, uint8_t byte)
 {
+    InterruptChanged();  // Requests ignored while not READY get through on the next update
     uint16_t mode = m_PICflags & PIC_MODE_MASK;
     if (!a)
     {
@@ -1421,23 +1733,31 @@ void CMotherboard::SetPICInterrupt(int signal, bool set)
         if ((m_PICRR & s) == 0)
         {
             m_PICRR |= s;
+            InterruptChanged();
             DebugLogFormat(_T("%c%06ho\tSET PIC INT%d, PICRR 0x%02hx PICMR 0x%02hx\n"), HU_INSTRUCTION_PC, signal, m_PICRR, m_PICMR);
         }
     }
     else
     {
         if ((m_PICRR & s) != 0)
+        {
             m_PICRR &= ~s;
+            InterruptChanged();
+        }
     }
 }
 
+// Level of the interrupt sources goes to the PIC, PIC and PPI state to the CPU HALT pin;
+// called when InterruptChanged() notified of a change, not after every instruction
 void CMotherboard::UpdateInterrupts()
 {
+    m_intupdates++;
     SetPICInterrupt(1, m_pFloppyCtl->CheckInterrupt() || m_hdint);
     SetPICInterrupt(4, m_keyint);
     bool ioint = ((m_PICRR & ~m_PICMR) != 0);
     m_PPIBrd = (m_PPIBrd & ~4) | (ioint ? 4 : 0);  // Update PB2(IOINT) signal
     m_pCPU->SetHALTPin((m_PPIBrd & 11) != 11 || ioint);  // EF0 EF1, IHLT or IOINT
+    m_intchanged = false;
 }
 
 // Get port value for Real Time Clock - ports 0161400..0161476 - КР512ВИ1 == MC146818
@@ -1522,6 +1842,8 @@ void CMotherboard::ProcessRtcWrite(uint16_t address, uint8_t byte)
 //
 void CMotherboard::SaveToImage(uint8_t* pImage)
 {
+    UpdateTimers(m_pCPU->GetTicks());
+
     // Board data
     uint16_t* pwImage = reinterpret_cast<uint16_t*>(pImage + 32);
     *pwImage++ = m_Configuration;
@@ -1581,7 +1903,7 @@ void CMotherboard::SaveToImage(uint8_t* pImage)
     *pImageTimer++ = (uint8_t)(lnow->tm_year % 100);  // Year
     *pImageTimer++ = 0;  // RESERVED
     *pImageTimer++ = 0;  // RESERVED
-    *(uint16_t*)pImageTimer = m_rtcticks;
+    *(uint16_t*)pImageTimer = (uint16_t)(15625 - (m_events[BOARDEVT_RTC] - m_pCPU->GetTicks()) / m_usticks);  // 64 Hz RTC ticks counter
     pImageTimer += 2;
     memcpy(pImageTimer, m_rtcmemory, sizeof(m_rtcmemory));  // 50 bytes
 
@@ -1624,6 +1946,8 @@ void CMotherboard::LoadFromImage(const uint8_t* pImage)
     pwImage += sizeof(m_HR) / 2;
     memcpy(m_UR, pwImage, sizeof(m_UR));  // 32 bytes
     pwImage += 8 / 2;  // RESERVED
+    UpdateMemoryWindows();
+    UpdateCPUClock();
     // HDD controller
     m_hdsdh = *pwImage++;
     m_hdscnt = (uint8_t) * pwImage++;
@@ -1648,6 +1972,7 @@ void CMotherboard::LoadFromImage(const uint8_t* pImage)
     memcpy(m_snl.m_chan, pwImage, sizeof(m_snl.m_chan));  // 30 bytes
     pwImage += 30 / 2;
     memcpy(m_snd.m_chan, pwImage, sizeof(m_snd.m_chan));  // 30 bytes
+    ResetSound();
     // Timer
     const uint8_t* pImageTimer = pImage + 256;
     pImageTimer++;  // Seconds
@@ -1661,13 +1986,21 @@ void CMotherboard::LoadFromImage(const uint8_t* pImage)
     pImageTimer++;  // Month
     pImageTimer++;  // Year
     pImageTimer += 2;  // RESERVED
-    m_rtcticks = *(const uint16_t*)pImageTimer;
+    uint16_t rtcticks = *(const uint16_t*)pImageTimer;  // 64 Hz RTC ticks counter
+    if (rtcticks >= 15625) rtcticks = 0;
+    m_events[BOARDEVT_RTC] = (m_pCPU->GetTicks() / m_usticks + 15625 - rtcticks) * m_usticks;
     pImageTimer += 2;
     memcpy(m_rtcmemory, pImageTimer, sizeof(m_rtcmemory));  // 50 bytes
 
     // CPU status
     const uint8_t* pImageCPU = pImage + 432;
     m_pCPU->LoadFromImage(pImageCPU);
+    // The image has no times of the periodic events: they start over from the current tick, as after
+    // the construction, so every run from the same image goes the same way, whatever ran before
+    uint64_t ticks = m_pCPU->GetTicks();
+    m_timernext = ticks + m_usticks / 2;
+    m_events[BOARDEVT_FRAME50] = ticks + 10001 * m_usticks;  // After frametick 10000
+    m_events[BOARDEVT_SOUND] = ticks + 1000 * m_usticks;
     // HD buffers 2K
     const uint8_t* pImageBuffer2K = pImage + 512;
     memcpy(m_pHDbuff, pImageBuffer2K, 2048);
@@ -1677,19 +2010,28 @@ void CMotherboard::LoadFromImage(const uint8_t* pImage)
     // RAM
     const uint8_t* pImageRam = pImage + 20480;
     memcpy(m_pRAM, pImageRam, 4096 * 1024);
+
+    ClearCodePages();
+    UpdateInterrupts();
 }
 
 
 //////////////////////////////////////////////////////////////////////
 
-void CMotherboard::DoSound(uint16_t s0, uint16_t s1, uint16_t s2)
+// Give out the sound samples complete up to the PIT tick done
+void CMotherboard::DoSound()
 {
-    if (m_SoundGenCallback == nullptr)
-        return;
+    for (uint32_t count = m_synth.GetSamplesReady(m_timerticks); count > 0; count--)
+    {
+        int sample = m_synth.ReadSample();
+        if (m_SoundGenCallback == nullptr)
+            continue;
 
-    uint16_t sound = (uint16_t)(((uint32_t)s0 + (uint32_t)s1 + (uint32_t)s2) / 3);
+        // The band-limited steps overshoot a bit
+        uint16_t sound = (uint16_t)(sample < 0 ? 0 : (sample > 65535 ? 65535 : sample));
 
-    (*m_SoundGenCallback)(sound, sound);
+        (*m_SoundGenCallback)(sound, sound);
+    }
 }
 
 void CMotherboard::SetSoundGenCallback(SOUNDGENCALLBACK callback)
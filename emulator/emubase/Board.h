@@ -35,6 +35,7 @@ class CHardDrive;
 // Machine configurations
 enum NeonConfiguration
 {
+    NEON_COPT_CPUCLOCK_MASK = 15,  // bits 0-3: CPU clock multiplier, 0 = 1 = nominal 8 MHz; devices keep real time
     NEON_COPT_RAMBANK0_MASK = 3 << 4,  // bits 4-5
     NEON_COPT_RAMBANK1_MASK = 3 << 6,  // bits 6-7
     NEON_COPT_RAMSIZE_MASK = 4096 | 2048 | 1024 | 512,  // bits 9-12
@@ -60,6 +61,10 @@ enum NeonConfiguration
 #define FLOPPY_FSM_WAITFORTERM1 2
 #define FLOPPY_FSM_WAITFORTERM2 3
 
+// Accuracy levels, see CMotherboard::SetAccuracy()
+#define ACCURACY_EXACT       0  // Instruction timings from the tables
+#define ACCURACY_FUNCTIONAL  1  // Every instruction takes FUNCTIONAL_TIMING ticks
+
 // Trace flags
 #define TRACE_NONE         0  // Turn off all tracing
 #define TRACE_FLOPPY    0100  // Trace floppies
@@ -81,6 +86,22 @@ enum NeonConfiguration
 #define NOBREAKPOINT 0xFFFFFFFF
 #define BREAKPOINT_HALT 0x80000000
 
+// Board scheduled events; events due at the same tick are processed in this order
+enum BoardEvent
+{
+    BOARDEVT_RTC = 0,       // RTC tick, 64 Hz
+    BOARDEVT_FRAME50 = 1,   // Frame sync, 50 Hz
+    BOARDEVT_FDD = 2,       // Floppy write timeout, flush the changes
+    BOARDEVT_HDD = 3,       // Hard drive operation timeout
+    BOARDEVT_SOUND = 4,     // Sound samples output, every 1 ms
+    BOARDEVT_COUNT = 5
+};
+#define BOARDEVT_NEVER 0xFFFFFFFFFFFFFFFFull  // Event time for not scheduled event
+
+// Code pages: RAM pages the CPU fetched instructions from, see CMotherboard::MarkCodePage()
+#define CODEPAGE_SHIFT  9  // 512-byte pages
+#define CODEPAGE_COUNT  (4096 * 1024 >> CODEPAGE_SHIFT)
+
 
 //////////////////////////////////////////////////////////////////////
 // Special key codes
@@ -94,6 +115,9 @@ typedef void (CALLBACK* SERIALOUTCALLBACK)(uint8_t byte);
 // Parallel port output callback
 typedef void (CALLBACK* PARALLELOUTCALLBACK)(uint8_t byte);
 
+// Code write callback: RAM offset written on a code page, the decoded instructions there are invalidated
+typedef void (CALLBACK* CODEWRITECALLBACK)(uint32_t offset);
+
 
 //////////////////////////////////////////////////////////////////////
 
@@ -124,8 +148,13 @@ public:
     void        SetGate(uint8_t chan, bool gate);
     void        Tick();
     bool        GetOutput(uint8_t chan) const;
+    // Run the channel nTicks with the gate kept at its level, same as nTicks calls of Tick();
+    // okStopOnEdge: stop after the tick changing the output. Returns the ticks done,
+    // adds the ticks ending with the output high to *pHigh unless it is nullptr
+    uint32_t    Advance(uint8_t channel, uint32_t nTicks, bool okStopOnEdge, uint32_t* pHigh);
 private:
     void        Tick(uint8_t channel);
+    static uint32_t Skip(PIT8253_chan& chan, uint32_t nTicks, bool okStopOnEdge, uint32_t* pHigh);
 };
 
 inline void PIT8253::SetGate(uint8_t chan, bool gate)
@@ -149,6 +178,44 @@ inline void PIT8253::Tick()
 }
 
 
+//////////////////////////////////////////////////////////////////////
+
+#define SOUNDSYNTH_TICKRATE  2000000  // Timestamps of the level changes: PIT ticks, 2 MHz
+#define SOUNDSYNTH_PHASEBITS 5
+#define SOUNDSYNTH_PHASES    (1 << SOUNDSYNTH_PHASEBITS)  // Sub-sample positions of a band-limited step
+#define SOUNDSYNTH_TAPS      16   // Samples a band-limited step is spread over
+#define SOUNDSYNTH_BUFSIZE   256  // Samples in progress, power of 2
+#define SOUNDSYNTH_UNITBITS  12   // Fixed point bits of the kernel taps and the level
+
+// Band-limited step synthesizer: the output level changes come with their PIT tick timestamps,
+// every change goes into the samples at the output rate as a band-limited step (BLEP)
+class CSoundSynth
+{
+public:
+    CSoundSynth();
+    void        SetSampleRate(int samplerate) { m_samplerate = samplerate; }  // Reset() is due after
+    int         GetSampleRate() const { return m_samplerate; }
+    // Start over at the PIT tick with the output level, the samples in progress are dropped
+    void        Reset(uint64_t ticks, int level);
+    // The output level changes by delta from the PIT tick on; the changes come less than
+    // SOUNDSYNTH_BUFSIZE - SOUNDSYNTH_TAPS samples ahead of the samples read
+    void        AddDelta(uint64_t ticks, int delta);
+    // Number of samples complete when the changes are added up to the PIT tick
+    uint32_t    GetSamplesReady(uint64_t ticks) const;
+    int         ReadSample();  // Take the next complete sample, may overshoot the levels a bit
+private:
+    uint64_t    GetPosition(uint64_t ticks) const;
+private:
+    int         m_samplerate;   // Output sample rate, Hz
+    uint64_t    m_origin;       // PIT tick of the sample 0
+    uint32_t    m_read;         // Samples read since m_origin
+    uint32_t    m_shift;        // Buffer slot of the sample 0
+    int32_t     m_level;        // Output level of the samples read, SOUNDSYNTH_UNITBITS fixed point
+    int32_t     m_buffer[SOUNDSYNTH_BUFSIZE];  // Level changes of the samples in progress
+    int16_t     m_kernel[SOUNDSYNTH_PHASES][SOUNDSYNTH_TAPS];  // Band-limited impulse by sub-sample phase
+};
+
+
 //////////////////////////////////////////////////////////////////////
 
 // Soyuz-Neon computer
@@ -169,35 +236,88 @@ private:  // Memory
     uint8_t*    m_pRAM;  // RAM, 4096 KB
     uint16_t    m_HR[8];
     uint16_t    m_UR[8];
+    struct MemoryWindow  // 8 KB window of the address space, see UpdateMemoryWindows()
+    {
+        uint32_t offset;    // Offset of the window start in the memory plane
+        int      addrtype;  // ADDRTYPE_Xxx for the whole window, -1 = translate every address
+    };
+    MemoryWindow m_windows[2][8];  // Translation of USER and HALT mode windows, by HR/UR and configuration
+    const uint8_t* m_readmap[2][8];  // Host memory of the windows plain to read, nullptr = not plain
+    uint8_t*    m_writemap[2][8];  // Host memory of the windows plain to write (RAM with no masking), nullptr = not plain
     uint32_t    m_nRamSizeBytes;  // Actual RAM size
     uint8_t*    m_pHDbuff;  // HD buffers, 2K
+    uint32_t    m_codepages[CODEPAGE_COUNT / 32];  // Code page bitmap, one bit per RAM page
+    uint32_t    m_codewrites;  // Writes to code pages, this frame
+    uint32_t    m_codeinvalidations;  // Decoded instructions dropped by the writes, this frame
 public:  // Memory access
     uint16_t    GetRAMWord(uint32_t offset) const;
     uint8_t     GetRAMByte(uint32_t offset) const;
-    void        SetRAMWord(uint32_t offset, uint16_t word) { *((uint16_t*)(m_pRAM + offset)) = word; }
+    void        SetRAMWord(uint32_t offset, uint16_t word);
     void        SetRAMWord2(uint32_t offset, uint16_t word);
     void        SetRAMWord4(uint32_t offset, uint16_t word);
-    void        SetRAMByte(uint32_t offset, uint8_t byte) { m_pRAM[offset] = byte; }
+    void        SetRAMByte(uint32_t offset, uint8_t byte);
     void        SetRAMByte2(uint32_t offset, uint8_t byte);
     void        SetRAMByte4(uint32_t offset, uint8_t byte);
     uint16_t    GetROMWord(uint16_t offset) const;
     uint8_t     GetROMByte(uint16_t offset) const;
     uint32_t    GetRamSizeBytes() const { return m_nRamSizeBytes; }
+    // Host memory to read/write the address directly, or nullptr to go through GetWord/SetWord etc.
+    const uint8_t* GetReadPointer(uint16_t address, bool okHaltMode) const
+    {
+        const uint8_t* p = m_readmap[okHaltMode ? 1 : 0][address >> 13];
+        return (p == nullptr) ? nullptr : p + (address & 017777);
+    }
+    uint8_t*    GetWritePointer(uint16_t address, bool okHaltMode) const
+    {
+        uint8_t* p = m_writemap[okHaltMode ? 1 : 0][address >> 13];
+        return (p == nullptr) ? nullptr : p + (address & 017777);
+    }
+    uint32_t    GetRAMOffset(const uint8_t* p) const { return (uint32_t)(p - m_pRAM); }
+    // Code pages: RAM pages with instructions fetched from; only writes there have to invalidate decoded instructions
+    void        MarkCodePage(uint32_t offset)
+    { m_codepages[offset >> (CODEPAGE_SHIFT + 5)] |= 1u << ((offset >> CODEPAGE_SHIFT) & 31); }
+    bool        IsCodePage(uint32_t offset) const
+    { return (m_codepages[offset >> (CODEPAGE_SHIFT + 5)] & (1u << ((offset >> CODEPAGE_SHIFT) & 31))) != 0; }
+    // Called on every RAM write
+    void        CheckCodeWrite(uint32_t offset) { if (IsCodePage(offset)) CodeWrite(offset); }
+    void        ClearCodePages();  // Forget all code pages and decoded instructions, on RAM reload
+    int         GetCodePageCount() const;
+    uint32_t    GetCodeWriteCount() const { return m_codewrites; }  // Writes to code pages in the last frame
+    uint32_t    GetCodeInvalidationCount() const { return m_codeinvalidations; }  // Decoded instructions dropped in the last frame
 public:  // Debug
     void        DebugTicks();  // One Debug CPU tick -- use for debug step or debug breakpoint
-    void        SetCPUBreakpoints(const uint32_t* bps) { m_CPUbps = bps; } // Set CPU breakpoint list
+    void        SetCPUBreakpoint(uint16_t address, bool ishalt, bool set = true);  // Set or clear CPU breakpoint
+    void        ClearCPUBreakpoints();  // Clear all CPU breakpoints
+    bool        IsCPUBreakpoint(uint16_t address, bool ishalt) const
+    { return (m_CPUbpmap[ishalt ? 1 : 0][address >> 5] & (1u << (address & 31))) != 0; }
     uint32_t    GetTrace() const { return m_dwTrace; }
     void        SetTrace(uint32_t dwTrace);
 public:  // System control
     void        SetConfiguration(uint16_t conf);
     uint16_t    GetConfiguration() const { return m_Configuration; }
+    int         GetCPUClockMultiplier() const { return (int)(m_usticks / 8); }
     void        SetTimer50or64(bool value) { m_timer50or64 = value; }
+    // Complete plain USER reads of the emulated registers inline when the ROM has nothing to do on read;
+    // the read of a read-modify-write command still goes to the ROM, the write needs it to set HR0/HR1
+    void        SetEmulFastPath(bool value) { m_okEmulFastPath = value; }
+    // Exact CPU timing, or the same cost for every instruction; see ACCURACY_Xxx constants
+    void        SetAccuracy(int accuracy);
+    // Sound output sample rate, Hz, SOUNDSAMPLERATE by default; a multiple of 25 gives the same samples every frame
+    void        SetSoundSampleRate(int samplerate);
+    int         GetSoundSampleRate() const { return m_synth.GetSampleRate(); }
     void        LoadROM(const uint8_t* pBuffer);  // Load 16 KB ROM image from the buffer
     void        Reset();  // Reset computer
     void        Tick50();           // Tick 50 Hz
-    void        TimerTick();        // Timer Tick
     void        ResetDevices();     // INIT signal
     bool        SystemFrame();  // Do one frame -- use for normal run
+    bool        InstructionDone();  // Called from CProcessor after every instruction; returns false on breakpoint
+    // Interrupt source edge: floppy, HDD, keyboard, PIC or PPI; the lines are re-evaluated after the instruction.
+    // For use inside an instruction or a board event; the setters called from the UI update the lines at once
+    void        InterruptChanged() { m_intchanged = true; }
+    uint32_t    GetInterruptUpdateCount() const { return m_intupdates; }  // UpdateInterrupts() calls in the last frame
+    // Schedule the device event after the given number of 1 us ticks; 0 = cancel the event
+    void        ScheduleEvent(int event, uint32_t timeout);
+    uint64_t    GetDeviceTime() const;  // Current time in 1 us ticks, the ScheduleEvent() unit
     void        UpdateKeyboardMatrix(const uint8_t matrix[8]);
     void        MouseMove(short dx, short dy, bool btnLeft, bool btnRight);
     uint16_t    GetPrinterOutPort() const { return m_PPIBwr; }
@@ -226,17 +346,18 @@ public:  // Callbacks
     void        SetSoundGenCallback(SOUNDGENCALLBACK callback);
     void        SetSerialOutCallback(SERIALOUTCALLBACK outcallback);
     void        SetParallelOutCallback(PARALLELOUTCALLBACK outcallback);
+    void        SetCodeWriteCallback(CODEWRITECALLBACK callback) { m_CodeWriteCallback = callback; }
 public:  // Memory
     // Read command for execution
     uint16_t GetWordExec(uint16_t address, bool okHaltMode) { return GetWord(address, okHaltMode, true); }
     // Read word from memory
     uint16_t GetWord(uint16_t address, bool okHaltMode) { return GetWord(address, okHaltMode, false); }
-    // Read word
-    uint16_t GetWord(uint16_t address, bool okHaltMode, bool okExec);
+    // Read word; isRMW for the read of a read-modify-write command
+    uint16_t GetWord(uint16_t address, bool okHaltMode, bool okExec, bool isRMW = false);
     // Write word
     void SetWord(uint16_t address, bool okHaltMode, uint16_t word, bool isRMW = false);
-    // Read byte
-    uint8_t GetByte(uint16_t address, bool okHaltMode);
+    // Read byte; isRMW for the read of a read-modify-write command
+    uint8_t GetByte(uint16_t address, bool okHaltMode, bool isRMW = false);
     // Write byte
     void SetByte(uint16_t address, bool okHaltMode, uint8_t byte, bool isRMW = false);
     // Read word from memory for video renderer and debugger
@@ -246,13 +367,28 @@ public:  // Memory
     uint32_t GetRAMFullAddress(uint16_t address, bool okHaltMode) const;
     // Read word from port for debugger
     uint16_t GetPortView(uint16_t address) const;
+    // Check that reading the address has no side effects and gives the same value until a CPU write or a board event
+    bool IsReadStable(uint16_t address, bool okHaltMode) const;
     // Read SEL register
     static uint16_t GetSelRegister() { return 0; }
     // Determine memory type for the given address - see ADDRTYPE_Xxx constants
     //   okHaltMode - processor mode (USER/HALT)
     //   okExec - true: read instruction for execution; false: read memory
     //   pOffset - result - offset in memory plane
-    int TranslateAddress(uint16_t address, bool okHaltMode, bool okExec, uint32_t* pOffset) const;
+    int TranslateAddress(uint16_t address, bool okHaltMode, bool /*okExec*/, uint32_t* pOffset) const
+    {
+        const MemoryWindow& window = m_windows[okHaltMode ? 1 : 0][address >> 13];
+        if (window.addrtype < 0)
+            return TranslateAddressSlow(address, okHaltMode, pOffset);
+        *pOffset = window.offset + (address & 017777);
+        return window.addrtype;
+    }
+private:
+    int         TranslateAddressSlow(uint16_t address, bool okHaltMode, uint32_t* pOffset) const;
+    void        UpdateMemoryWindow(bool okHaltMode, int window);
+    void        UpdateMemoryWindows();  // Call on HR/UR or configuration change
+    void        UpdateCPUClock();  // Call on configuration change
+    bool        ProcessEmulReadFast(uint16_t address);
 private:  // Access to I/O ports
     uint16_t    GetPortWord(uint16_t address);
     void        SetPortWord(uint16_t address, uint16_t word);
@@ -283,27 +419,43 @@ private:  // Ports/devices: implementation
     PIT8253     m_snd, m_snl;
     uint8_t     m_rtcalarmsec, m_rtcalarmmin, m_rtcalarmhour;
     uint8_t     m_rtcmemory[50];
-    uint16_t    m_rtcticks;         // Counter for 64 Hz RTC ticks
     bool        m_timer50or64;      // Timer frequency: false = 64 Hz RTC, true = 50 Hz
+    bool        m_okEmulFastPath;   // USER reads of plain emulated registers skip the HALT mode round trip
+    bool        m_intchanged;       // Interrupt source changed, UpdateInterrupts() due after the instruction
+    uint32_t    m_intupdates;       // UpdateInterrupts() calls, this frame
+    uint64_t    m_events[BOARDEVT_COUNT];  // CPU tick when the event is due, see BoardEvent enum
+    uint64_t    m_timernext;        // CPU tick of the next 2 MHz PIT tick; the PITs run on demand, see UpdateTimers()
+    uint32_t    m_usticks;          // CPU ticks per 1 us device tick: 8 at nominal clock, times the CPU clock multiplier
+    uint64_t    m_timerticks;       // 2 MHz PIT ticks done, the sound timestamps
+    bool        m_soundlevel[3];    // Sound channel levels: m_snd and m_snl outputs of the channel both high
+    CSoundSynth m_synth;            // Sound synthesis from the channel level changes
 private:
     void        ProcessPICWrite(bool a, uint8_t byte);
     uint8_t     ProcessPICRead(bool a);
     void        SetPICInterrupt(int signal, bool set = true);  // Set/reset PIC interrupt signal 0..7
-    void        UpdateInterrupts();
+    void        UpdateInterrupts();  // Re-evaluate PIC requests, IOINT and the CPU HALT pin
     uint8_t     ProcessRtcRead(uint16_t address) const;
     void        ProcessRtcWrite(uint16_t address, uint8_t byte);
+    void        UpdateTimers(uint64_t ticks);  // Run the PITs up to the CPU tick
+    void        AdvanceTimers(uint32_t nTicks);
+    void        SetSoundLevel(uint8_t chan, uint64_t ticks, bool level);
+    void        ResetSound();  // Start the sound synthesis over from the current PIT outputs
     void        ProcessTimerWrite(uint16_t address, uint8_t byte);
     uint8_t     ProcessTimerRead(uint16_t address);
     void        ProcessKeyboardWrite(uint8_t byte);
     void        ProcessMouseWrite(uint8_t byte);
-    void        DoSound(uint16_t s0, uint16_t s1, uint16_t s2);
+    void        DoSound();
+    void        ProcessEvent(int event);
+    void        CodeWrite(uint32_t offset);
 private:
-    const uint32_t* m_CPUbps;  // CPU breakpoint list, ends with NOBREAKPOINT value
+    uint32_t    m_CPUbpmap[2][65536 / 32];  // CPU breakpoint bitmaps for USER and HALT mode, one bit per address
+    int         m_CPUbpcount;  // Number of bits set in m_CPUbpmap
     uint32_t    m_dwTrace;  // Trace flags
 private:
     SOUNDGENCALLBACK m_SoundGenCallback;
     SERIALOUTCALLBACK m_SerialOutCallback;
     PARALLELOUTCALLBACK m_ParallelOutCallback;
+    CODEWRITECALLBACK m_CodeWriteCallback;
 };
 
 
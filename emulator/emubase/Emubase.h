@@ -19,7 +19,7 @@ NEONBTL. If not, see <http://www.gnu.org/licenses/>. */
 //////////////////////////////////////////////////////////////////////
 
 
-#define SOUNDSAMPLERATE  22050
+#define SOUNDSAMPLERATE  44100
 
 
 //////////////////////////////////////////////////////////////////////
@@ -96,7 +96,7 @@ struct CFloppyDrive
     uint8_t* data;          // Data image for the whole disk
     uint32_t datasize;
     uint32_t dirtystart, dirtyend;  // Range of unsaved data; dirtyend == 0 means everything saved
-    uint16_t dirtycount;
+    uint64_t flushtime;     // Device time to save the unsaved data, see CMotherboard::GetDeviceTime()
     bool     okReadOnly;    // Write protection flag
 
 public:
@@ -152,7 +152,7 @@ public:
     uint16_t GetStateView() const { return m_state; }  // Get status value for debugger
     void     FifoWrite(uint8_t cmd);  // Writing commands
     uint8_t  FifoRead();
-    void Periodic();            // Rotate disk; call it each 64 us - 15625 times per second
+    void FlushTimeout();        // Save unsaved data when the write timeout expired, see BOARDEVT_FDD
     bool CheckInterrupt() const { return m_int; }
     void SetTrace(bool okTrace) { m_okTrace = okTrace; }  // Set trace mode on/off
 
@@ -161,6 +161,8 @@ private:
     void StartCommand(uint8_t cmd);
     void ExecuteCommand(uint8_t cmd);
     void FlushChanges();  // Save all unsaved data
+    void ScheduleFlush();  // Schedule BOARDEVT_FDD for the earliest drive flush time
+    void SetInterrupt(bool value);  // Set the interrupt flag, notify the board on change
 };
 
 
@@ -173,6 +175,7 @@ private:
 class CHardDrive
 {
 protected:
+    CMotherboard* m_pBoard;
     FILE*   m_fpFile;           // File pointer for the attached HDD image
     bool    m_okReadOnly;       // Flag indicating that the HDD image file is read-only
     uint8_t m_status;           // IDE status register, see IDE_STATUS_XXX constants
@@ -187,11 +190,10 @@ protected:
     int     m_sectorcount;      // Sector counter for read/write operations
     uint8_t m_buffer[IDE_DISK_SECTOR_SIZE];  // Sector data buffer
     int     m_bufferoffset;     // Current offset within sector: 0..511
-    int     m_timeoutcount;     // Timeout counter to wait for the next event
     int     m_timeoutevent;     // Current stage of operation, see TimeoutEvent enum
 
 public:
-    CHardDrive();
+    CHardDrive(CMotherboard* pBoard);
     ~CHardDrive();
     // Reset the device.
     void Reset();
@@ -207,12 +209,13 @@ public:
     uint16_t ReadPort(uint16_t port);
     // Write word th the device port
     void WritePort(uint16_t port, uint16_t data);
-    // Rotate disk
-    void Periodic();
+    // Process the operation stage when the scheduled timeout expired, see BOARDEVT_HDD
+    void ProcessTimeout();
 
 private:
     uint32_t CalculateOffset() const;  // Calculate sector offset in the HDD image
     void HandleCommand(uint8_t command);  // Handle the IDE command
+    void ScheduleTimeout(int timeout, int event);  // Schedule the next stage after timeout in 1 us ticks
     void ReadNextSector();
     void ReadSectorDone();
     void WriteSectorDone();
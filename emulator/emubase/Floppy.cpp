@@ -27,7 +27,7 @@ CFloppyDrive::CFloppyDrive()
     okReadOnly = false;
     data = nullptr;
     datasize = dirtystart = dirtyend = 0;
-    dirtycount = 0;
+    flushtime = 0;
 }
 
 void CFloppyDrive::Reset()
@@ -43,7 +43,6 @@ void CFloppyDrive::WriteBlock(uint16_t block, const uint8_t* src)
     if (dirtyend == 0 || offset < dirtystart)
         dirtystart = offset;
     if (dirtyend < offset + 512) dirtyend = offset + 512;
-    dirtycount = 15625 * 3;  // 3 sec
 }
 
 void CFloppyDrive::Flush()
@@ -59,7 +58,6 @@ void CFloppyDrive::Flush()
     //TODO: check for bytes written
 
     dirtystart = dirtyend = 0;
-    dirtycount = 0;
 }
 
 
@@ -96,7 +94,7 @@ void CFloppyController::Reset()
     m_pDrive = m_drivedata;
     m_phase = FLOPPY_PHASE_CMD;
     m_state = FLOPPY_STATE_IDLE;
-    m_int = false;
+    SetInterrupt(false);
     m_commandlen = m_resultlen = m_resultpos = 0;
 }
 
@@ -158,6 +156,14 @@ void CFloppyController::DetachImage(int drive)
 //////////////////////////////////////////////////////////////////////
 
 
+void CFloppyController::SetInterrupt(bool value)
+{
+    if (m_int == value)
+        return;
+    m_int = value;
+    m_pBoard->InterruptChanged();
+}
+
 void CFloppyController::SetParams(uint8_t side, uint8_t /*density*/, uint8_t drive, uint8_t motor)
 {
     if (m_okTrace) DebugLogFormat(_T("Floppy SETPARAMS drive:%d side:%d motor:%d\r\n"), drive, side, motor);
@@ -198,7 +204,7 @@ void CFloppyController::FifoWrite(uint8_t data)
 
     if (m_phase == FLOPPY_PHASE_CMD)
     {
-        m_int = false;
+        SetInterrupt(false);
         m_command[m_commandlen++] = data;
 
         uint8_t cmd = CheckCommand();
@@ -231,7 +237,7 @@ uint8_t CFloppyController::FifoRead()
     case FLOPPY_PHASE_EXEC:
         break;
     case FLOPPY_PHASE_RESULT:
-        m_int = false;//TODO: not sure it should be here
+        SetInterrupt(false);//TODO: not sure it should be here
         if (m_resultpos < m_resultlen)
         {
             r = m_result[m_resultpos++];
@@ -322,7 +328,7 @@ void CFloppyController::ExecuteCommand(uint8_t cmd)
         m_result[5] = m_command[4];
         m_result[6] = m_command[5];
         m_resultlen = 7;
-        m_int = true;//DEBUG
+        SetInterrupt(true);//DEBUG
         if (m_drive == 0xff || m_pDrive == nullptr || !IsAttached(m_drive) ||
             m_command[2] >= FLOPPY_MAX_TRACKS - 1)
         {
@@ -348,13 +354,13 @@ void CFloppyController::ExecuteCommand(uint8_t cmd)
         if (m_okTrace) DebugLogFormat(_T("Floppy CMD RECALIBRATE 0x%02hx\r\n"), (uint16_t)m_command[1]);
         //TODO: m_state = FLOPPY_STATE_RECALIBRATE;
         m_phase = FLOPPY_PHASE_CMD;//DEBUG
-        m_int = true;//DEBUG
+        SetInterrupt(true);//DEBUG
         break;
 
     case FLOPPY_COMMAND_SEEK:
         if (m_okTrace) DebugLogFormat(_T("Floppy CMD SEEK 0x%02hx 0x%02hx\r\n"), (uint16_t)m_command[1], (uint16_t)m_command[2]);
         m_phase = FLOPPY_PHASE_CMD;//DEBUG
-        m_int = true;//DEBUG
+        SetInterrupt(true);//DEBUG
         break;
 
     case FLOPPY_COMMAND_SENSE_INTERRUPT_STATUS:
@@ -366,7 +372,7 @@ void CFloppyController::ExecuteCommand(uint8_t cmd)
             m_result[0] = 0x20;  // Normal termination
         m_result[1] = 0x00;
         m_resultlen = 2;
-        m_int = false;
+        SetInterrupt(false);
         break;
 
     case FLOPPY_COMMAND_SPECIFY:
@@ -388,7 +394,7 @@ void CFloppyController::ExecuteCommand(uint8_t cmd)
         m_result[5] = m_command[4];
         m_result[6] = m_command[5];
         m_resultlen = 7;
-        m_int = true;//DEBUG
+        SetInterrupt(true);//DEBUG
         if (m_drive == 0xff || m_pDrive == nullptr || !IsAttached(m_drive) ||
             m_command[2] >= FLOPPY_MAX_TRACKS - 1)
         {
@@ -407,6 +413,8 @@ void CFloppyController::ExecuteCommand(uint8_t cmd)
                 m_pDrive->WriteBlock(block, pBuffer);
                 sector = (sector + 1) % 10;
             }
+            m_pDrive->flushtime = m_pBoard->GetDeviceTime() + 3000000;  // Flush after 3 sec
+            ScheduleFlush();
         }
         break;
 
@@ -415,18 +423,31 @@ void CFloppyController::ExecuteCommand(uint8_t cmd)
     }
 }
 
-void CFloppyController::Periodic()
+void CFloppyController::FlushTimeout()
 {
-    // Process flush after timeout
+    uint64_t now = m_pBoard->GetDeviceTime();
     for (int drive = 0; drive < 2; drive++)
     {
-        if (m_drivedata[drive].dirtycount > 0)
-        {
-            m_drivedata[drive].dirtycount--;
-            if (m_drivedata[drive].dirtycount == 0)
-                m_drivedata[drive].Flush();
-        }
+        if (m_drivedata[drive].IsDirty() && m_drivedata[drive].flushtime <= now)
+            m_drivedata[drive].Flush();
+    }
+    ScheduleFlush();
+}
+
+// Every drive keeps its own flush time, so writes to one drive do not delay the other
+void CFloppyController::ScheduleFlush()
+{
+    uint64_t now = m_pBoard->GetDeviceTime();
+    uint64_t next = 0;
+    for (int drive = 0; drive < 2; drive++)
+    {
+        if (m_drivedata[drive].IsDirty() && (next == 0 || m_drivedata[drive].flushtime < next))
+            next = m_drivedata[drive].flushtime;
     }
+    if (next == 0)
+        m_pBoard->ScheduleEvent(BOARDEVT_FDD, 0);  // Nothing to save
+    else
+        m_pBoard->ScheduleEvent(BOARDEVT_FDD, next > now ? (uint32_t)(next - now) : 1);
 }
 
 void CFloppyController::FlushChanges()
@@ -75,14 +75,15 @@ static void InvertBuffer(void* buffer)
 //////////////////////////////////////////////////////////////////////
 
 
-CHardDrive::CHardDrive()
+CHardDrive::CHardDrive(CMotherboard* pBoard)
+    : m_pBoard(pBoard)
 {
     m_fpFile = nullptr;
 
     m_status = IDE_STATUS_BUSY;
     m_error = IDE_ERROR_NONE;
     m_command = 0;
-    m_timeoutcount = m_timeoutevent = 0;
+    m_timeoutevent = TIMEEVT_NONE;
     m_sectorcount = 0;
 
     m_numsectors = m_numheads = m_numcylinders = 256;
@@ -104,8 +105,7 @@ void CHardDrive::Reset()
     m_status = IDE_STATUS_BUSY;
     m_error = IDE_ERROR_NONE;
     m_command = 0;
-    m_timeoutcount = 2;
-    m_timeoutevent = TIMEEVT_RESET_DONE;
+    ScheduleTimeout(2, TIMEEVT_RESET_DONE);
 }
 
 bool CHardDrive::AttachImage(LPCTSTR sFileName)
@@ -260,30 +260,30 @@ void CHardDrive::WritePort(uint16_t port, uint16_t data)
     }
 }
 
-// Called from CMotherboard::SystemFrame() every tick
-void CHardDrive::Periodic()
+// Schedule the board event for the next stage of the operation
+void CHardDrive::ScheduleTimeout(int timeout, int event)
 {
-    if (m_timeoutcount > 0)
+    m_timeoutevent = event;
+    m_pBoard->ScheduleEvent(BOARDEVT_HDD, timeout);
+}
+
+// Called from CMotherboard::SystemFrame() when the scheduled timeout expired
+void CHardDrive::ProcessTimeout()
+{
+    int evt = m_timeoutevent;
+    m_timeoutevent = TIMEEVT_NONE;
+    switch (evt)
     {
-        m_timeoutcount--;
-        if (m_timeoutcount == 0)
-        {
-            int evt = m_timeoutevent;
-            m_timeoutevent = TIMEEVT_NONE;
-            switch (evt)
-            {
-            case TIMEEVT_RESET_DONE:
-                m_status &= ~IDE_STATUS_BUSY;
-                m_status |= IDE_STATUS_DRIVE_READY | IDE_STATUS_SEEK_COMPLETE;
-                break;
-            case TIMEEVT_READ_SECTOR_DONE:
-                ReadSectorDone();
-                break;
-            case TIMEEVT_WRITE_SECTOR_DONE:
-                WriteSectorDone();
-                break;
-            }
-        }
+    case TIMEEVT_RESET_DONE:
+        m_status &= ~IDE_STATUS_BUSY;
+        m_status |= IDE_STATUS_DRIVE_READY | IDE_STATUS_SEEK_COMPLETE;
+        break;
+    case TIMEEVT_READ_SECTOR_DONE:
+        ReadSectorDone();
+        break;
+    case TIMEEVT_WRITE_SECTOR_DONE:
+        WriteSectorDone();
+        break;
     }
 }
 
@@ -299,8 +299,7 @@ void CHardDrive::HandleCommand(uint8_t command)
         m_status |= IDE_STATUS_BUSY;
         m_status &= ~IDE_STATUS_BUFFER_READY;
 
-        m_timeoutcount = TIME_PER_SECTOR * 3;  // Timeout while seek for track
-        m_timeoutevent = TIMEEVT_READ_SECTOR_DONE;
+        ScheduleTimeout(TIME_PER_SECTOR * 3, TIMEEVT_READ_SECTOR_DONE);  // Timeout while seek for track
         break;
 
         //case IDE_COMMAND_SET_CONFIG:
@@ -388,8 +387,7 @@ void CHardDrive::ReadNextSector()
 {
     m_status |= IDE_STATUS_BUSY;
 
-    m_timeoutcount = TIME_PER_SECTOR * 2;  // Timeout while seek for next sector
-    m_timeoutevent = TIMEEVT_READ_SECTOR_DONE;
+    ScheduleTimeout(TIME_PER_SECTOR * 2, TIMEEVT_READ_SECTOR_DONE);  // Timeout while seek for next sector
 }
 
 void CHardDrive::ReadSectorDone()
@@ -487,8 +485,7 @@ void CHardDrive::ContinueWrite()
     m_status &= ~IDE_STATUS_BUFFER_READY;
     m_status |= IDE_STATUS_BUSY;
 
-    m_timeoutcount = TIME_PER_SECTOR;
-    m_timeoutevent = TIMEEVT_WRITE_SECTOR_DONE;
+    ScheduleTimeout(TIME_PER_SECTOR, TIMEEVT_WRITE_SECTOR_DONE);
 }
 
 
@@ -12,6 +12,11 @@ NEONBTL. If not, see <http://www.gnu.org/licenses/>. */
 
 #include "stdafx.h"
 #include "Processor.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+void TraceInstruction(const CProcessor* pProc, const CMotherboard* pBoard, uint16_t address);
 
 
 // Timings ///////////////////////////////////////////////////////////
@@ -196,133 +201,91 @@ static uint16_t GetInstructionTiming12x12(const uint16_t timings[12][12], uint16
 //////////////////////////////////////////////////////////////////////
 
 
-CProcessor::ExecuteMethodRef* CProcessor::m_pExecuteMethodMap = nullptr;
-
-#define RegisterMethodOpc(/*uint16_t*/ opcode, /*CProcessor::ExecuteMethodRef*/ methodref) \
-    { m_pExecuteMethodMap[opcode] = (methodref); }
-
-#define RegisterMethodRef(/*uint16_t*/ opstart, /*uint16_t*/ opend, /*CProcessor::ExecuteMethodRef*/ methodref) \
-    { \
-        for (uint32_t opcode = (opstart); opcode <= (opend); opcode++) \
-            m_pExecuteMethodMap[opcode] = (methodref); \
-    }
-
-void CProcessor::Init()
-{
-    ASSERT(m_pExecuteMethodMap == nullptr);
-    m_pExecuteMethodMap = static_cast<CProcessor::ExecuteMethodRef*>(::calloc(65536, sizeof(CProcessor::ExecuteMethodRef)));
-
-    // Сначала заполняем таблицу ссылками на метод ExecuteUNKNOWN, выполняющий TRAP 10
-    RegisterMethodRef( 0000000, 0177777, &CProcessor::ExecuteUNKNOWN )
-
-    RegisterMethodOpc( 0000000, &CProcessor::ExecuteHALT )
-    RegisterMethodOpc( 0000001, &CProcessor::ExecuteWAIT )
-    RegisterMethodOpc( 0000002, &CProcessor::ExecuteRTI )
-    RegisterMethodOpc( 0000003, &CProcessor::ExecuteBPT )
-    RegisterMethodOpc( 0000004, &CProcessor::ExecuteIOT )
-    RegisterMethodOpc( 0000005, &CProcessor::ExecuteRESET )
-    RegisterMethodOpc( 0000006, &CProcessor::ExecuteRTT )
-
-    RegisterMethodRef( 0000010, 0000013, &CProcessor::ExecuteRUN )
-    RegisterMethodRef( 0000014, 0000017, &CProcessor::ExecuteSTEP )
-    RegisterMethodOpc( 0000020,          &CProcessor::ExecuteRSEL)
-    RegisterMethodOpc( 0000021,          &CProcessor::ExecuteMFUS)
-    RegisterMethodRef( 0000022, 0000023, &CProcessor::ExecuteRCPC)
-    RegisterMethodRef( 0000024, 0000027, &CProcessor::ExecuteRCPS)
-    RegisterMethodOpc( 0000030,          &CProcessor::ExecuteRSEL)
-    RegisterMethodOpc( 0000031,          &CProcessor::ExecuteMTUS)
-    RegisterMethodRef( 0000032, 0000033, &CProcessor::ExecuteWCPC)
-    RegisterMethodRef( 0000034, 0000037, &CProcessor::ExecuteWCPS)
-
-    RegisterMethodRef( 0000100, 0000177, &CProcessor::ExecuteJMP)
-    RegisterMethodRef( 0000200, 0000207, &CProcessor::ExecuteRTS)  // RTS / RETURN
-
-    RegisterMethodRef( 0000240, 0000257, &CProcessor::ExecuteCCC)
-
-    RegisterMethodRef( 0000260, 0000277, &CProcessor::ExecuteSCC)
-
-    RegisterMethodRef( 0000300, 0000377, &CProcessor::ExecuteSWAB)
-
-    RegisterMethodRef( 0000400, 0000777, &CProcessor::ExecuteBR)
-    RegisterMethodRef( 0001000, 0001377, &CProcessor::ExecuteBNE)
-    RegisterMethodRef( 0001400, 0001777, &CProcessor::ExecuteBEQ)
-    RegisterMethodRef( 0002000, 0002377, &CProcessor::ExecuteBGE)
-    RegisterMethodRef( 0002400, 0002777, &CProcessor::ExecuteBLT)
-    RegisterMethodRef( 0003000, 0003377, &CProcessor::ExecuteBGT)
-    RegisterMethodRef( 0003400, 0003777, &CProcessor::ExecuteBLE)
-
-    RegisterMethodRef( 0004000, 0004777, &CProcessor::ExecuteJSR)  // JSR / CALL
-
-    RegisterMethodRef( 0005000, 0005077, &CProcessor::ExecuteCLR)
-    RegisterMethodRef( 0005100, 0005177, &CProcessor::ExecuteCOM)
-    RegisterMethodRef( 0005200, 0005277, &CProcessor::ExecuteINC)
-    RegisterMethodRef( 0005300, 0005377, &CProcessor::ExecuteDEC)
-    RegisterMethodRef( 0005400, 0005477, &CProcessor::ExecuteNEG)
-    RegisterMethodRef( 0005500, 0005577, &CProcessor::ExecuteADC)
-    RegisterMethodRef( 0005600, 0005677, &CProcessor::ExecuteSBC)
-    RegisterMethodRef( 0005700, 0005777, &CProcessor::ExecuteTST)
-    RegisterMethodRef( 0006000, 0006077, &CProcessor::ExecuteROR)
-    RegisterMethodRef( 0006100, 0006177, &CProcessor::ExecuteROL)
-    RegisterMethodRef( 0006200, 0006277, &CProcessor::ExecuteASR)
-    RegisterMethodRef( 0006300, 0006377, &CProcessor::ExecuteASL)
-
-    RegisterMethodRef( 0006400, 0006477, &CProcessor::ExecuteMARK)
-    RegisterMethodRef( 0006700, 0006777, &CProcessor::ExecuteSXT)
-
-    RegisterMethodRef( 0010000, 0017777, &CProcessor::ExecuteMOV)
-    RegisterMethodRef( 0020000, 0027777, &CProcessor::ExecuteCMP)
-    RegisterMethodRef( 0030000, 0037777, &CProcessor::ExecuteBIT)
-    RegisterMethodRef( 0040000, 0047777, &CProcessor::ExecuteBIC)
-    RegisterMethodRef( 0050000, 0057777, &CProcessor::ExecuteBIS)
-    RegisterMethodRef( 0060000, 0067777, &CProcessor::ExecuteADD)
-
-    RegisterMethodRef( 0070000, 0070777, &CProcessor::ExecuteMUL)
-    RegisterMethodRef( 0071000, 0071777, &CProcessor::ExecuteDIV)
-    RegisterMethodRef( 0072000, 0072777, &CProcessor::ExecuteASH)
-    RegisterMethodRef( 0073000, 0073777, &CProcessor::ExecuteASHC)
-    RegisterMethodRef( 0074000, 0074777, &CProcessor::ExecuteXOR)
-    RegisterMethodRef( 0075000, 0075037, &CProcessor::ExecuteFIS)
-    RegisterMethodRef( 0077000, 0077777, &CProcessor::ExecuteSOB)
-
-    RegisterMethodRef( 0100000, 0100377, &CProcessor::ExecuteBPL)
-    RegisterMethodRef( 0100400, 0100777, &CProcessor::ExecuteBMI)
-    RegisterMethodRef( 0101000, 0101377, &CProcessor::ExecuteBHI)
-    RegisterMethodRef( 0101400, 0101777, &CProcessor::ExecuteBLOS)
-    RegisterMethodRef( 0102000, 0102377, &CProcessor::ExecuteBVC)
-    RegisterMethodRef( 0102400, 0102777, &CProcessor::ExecuteBVS)
-    RegisterMethodRef( 0103000, 0103377, &CProcessor::ExecuteBHIS)  // BCC
-    RegisterMethodRef( 0103400, 0103777, &CProcessor::ExecuteBLO)   // BCS
-
-    RegisterMethodRef( 0104000, 0104377, &CProcessor::ExecuteEMT)
-    RegisterMethodRef( 0104400, 0104777, &CProcessor::ExecuteTRAP)
-
-    RegisterMethodRef( 0105000, 0105077, &CProcessor::ExecuteCLRB)
-    RegisterMethodRef( 0105100, 0105177, &CProcessor::ExecuteCOMB)
-    RegisterMethodRef( 0105200, 0105277, &CProcessor::ExecuteINCB)
-    RegisterMethodRef( 0105300, 0105377, &CProcessor::ExecuteDECB)
-    RegisterMethodRef( 0105400, 0105477, &CProcessor::ExecuteNEGB)
-    RegisterMethodRef( 0105500, 0105577, &CProcessor::ExecuteADCB)
-    RegisterMethodRef( 0105600, 0105677, &CProcessor::ExecuteSBCB)
-    RegisterMethodRef( 0105700, 0105777, &CProcessor::ExecuteTSTB)
-    RegisterMethodRef( 0106000, 0106077, &CProcessor::ExecuteRORB)
-    RegisterMethodRef( 0106100, 0106177, &CProcessor::ExecuteROLB)
-    RegisterMethodRef( 0106200, 0106277, &CProcessor::ExecuteASRB)
-    RegisterMethodRef( 0106300, 0106377, &CProcessor::ExecuteASLB)
-
-    RegisterMethodRef( 0106400, 0106477, &CProcessor::ExecuteMTPS)
-    RegisterMethodRef( 0106700, 0106777, &CProcessor::ExecuteMFPS)
-
-    RegisterMethodRef( 0110000, 0117777, &CProcessor::ExecuteMOVB)
-    RegisterMethodRef( 0120000, 0127777, &CProcessor::ExecuteCMPB)
-    RegisterMethodRef( 0130000, 0137777, &CProcessor::ExecuteBITB)
-    RegisterMethodRef( 0140000, 0147777, &CProcessor::ExecuteBICB)
-    RegisterMethodRef( 0150000, 0157777, &CProcessor::ExecuteBISB)
-    RegisterMethodRef( 0160000, 0167777, &CProcessor::ExecuteSUB)
-}
-
-void CProcessor::Done()
-{
-    ::free(m_pExecuteMethodMap);  m_pExecuteMethodMap = nullptr;
+// Command implementation map, two levels: the 64-opcode block (instruction >> 6) gives the method,
+// or nullptr when the method depends on the low opcode bits, see GetExecuteMethod()
+#define MethodRef4(method) &CProcessor::method, &CProcessor::method, &CProcessor::method, &CProcessor::method
+#define MethodRef8(method) MethodRef4(method), MethodRef4(method)
+#define MethodRef64(method) \
+    MethodRef8(method), MethodRef8(method), MethodRef8(method), MethodRef8(method), \
+    MethodRef8(method), MethodRef8(method), MethodRef8(method), MethodRef8(method)
+
+const CProcessor::ExecuteMethodRef CProcessor::m_ExecuteMethodBlocks[1024] =
+{
+    // 000000-007777
+    nullptr, &CProcessor::ExecuteJMP, nullptr, &CProcessor::ExecuteSWAB,
+    MethodRef4(ExecuteBR),
+    MethodRef4(ExecuteBNE), MethodRef4(ExecuteBEQ), MethodRef4(ExecuteBGE), MethodRef4(ExecuteBLT),
+    MethodRef4(ExecuteBGT), MethodRef4(ExecuteBLE),
+    MethodRef8(ExecuteJSR),  // JSR / CALL
+    &CProcessor::ExecuteCLR, &CProcessor::ExecuteCOM, &CProcessor::ExecuteINC, &CProcessor::ExecuteDEC,
+    &CProcessor::ExecuteNEG, &CProcessor::ExecuteADC, &CProcessor::ExecuteSBC, &CProcessor::ExecuteTST,
+    &CProcessor::ExecuteROR, &CProcessor::ExecuteROL, &CProcessor::ExecuteASR, &CProcessor::ExecuteASL,
+    &CProcessor::ExecuteMARK, &CProcessor::ExecuteUNKNOWN, &CProcessor::ExecuteUNKNOWN, &CProcessor::ExecuteSXT,
+    MethodRef8(ExecuteUNKNOWN),
+    // 010000-067777
+    MethodRef64(ExecuteMOV), MethodRef64(ExecuteCMP), MethodRef64(ExecuteBIT),
+    MethodRef64(ExecuteBIC), MethodRef64(ExecuteBIS), MethodRef64(ExecuteADD),
+    // 070000-077777
+    MethodRef8(ExecuteMUL), MethodRef8(ExecuteDIV), MethodRef8(ExecuteASH), MethodRef8(ExecuteASHC),
+    MethodRef8(ExecuteXOR),
+    nullptr, &CProcessor::ExecuteUNKNOWN, MethodRef4(ExecuteUNKNOWN), &CProcessor::ExecuteUNKNOWN, &CProcessor::ExecuteUNKNOWN,
+    MethodRef8(ExecuteUNKNOWN),
+    MethodRef8(ExecuteSOB),
+    // 100000-107777
+    MethodRef4(ExecuteBPL), MethodRef4(ExecuteBMI), MethodRef4(ExecuteBHI), MethodRef4(ExecuteBLOS),
+    MethodRef4(ExecuteBVC), MethodRef4(ExecuteBVS), MethodRef4(ExecuteBHIS), MethodRef4(ExecuteBLO),  // BCC, BCS
+    MethodRef4(ExecuteEMT), MethodRef4(ExecuteTRAP),
+    &CProcessor::ExecuteCLRB, &CProcessor::ExecuteCOMB, &CProcessor::ExecuteINCB, &CProcessor::ExecuteDECB,
+    &CProcessor::ExecuteNEGB, &CProcessor::ExecuteADCB, &CProcessor::ExecuteSBCB, &CProcessor::ExecuteTSTB,
+    &CProcessor::ExecuteRORB, &CProcessor::ExecuteROLB, &CProcessor::ExecuteASRB, &CProcessor::ExecuteASLB,
+    &CProcessor::ExecuteMTPS, &CProcessor::ExecuteUNKNOWN, &CProcessor::ExecuteUNKNOWN, &CProcessor::ExecuteMFPS,
+    MethodRef8(ExecuteUNKNOWN),
+    // 110000-167777
+    MethodRef64(ExecuteMOVB), MethodRef64(ExecuteCMPB), MethodRef64(ExecuteBITB),
+    MethodRef64(ExecuteBICB), MethodRef64(ExecuteBISB), MethodRef64(ExecuteSUB),
+    // 170000-177777
+    MethodRef64(ExecuteUNKNOWN)
+};
+
+// 000000-000077
+const CProcessor::ExecuteMethodRef CProcessor::m_ExecuteMethods0000[64] =
+{
+    &CProcessor::ExecuteHALT, &CProcessor::ExecuteWAIT, &CProcessor::ExecuteRTI, &CProcessor::ExecuteBPT,
+    &CProcessor::ExecuteIOT, &CProcessor::ExecuteRESET, &CProcessor::ExecuteRTT, &CProcessor::ExecuteUNKNOWN,
+    MethodRef4(ExecuteRUN), MethodRef4(ExecuteSTEP),
+    &CProcessor::ExecuteRSEL, &CProcessor::ExecuteMFUS, &CProcessor::ExecuteRCPC, &CProcessor::ExecuteRCPC,
+    MethodRef4(ExecuteRCPS),
+    &CProcessor::ExecuteRSEL, &CProcessor::ExecuteMTUS, &CProcessor::ExecuteWCPC, &CProcessor::ExecuteWCPC,
+    MethodRef4(ExecuteWCPS),
+    MethodRef8(ExecuteUNKNOWN), MethodRef8(ExecuteUNKNOWN), MethodRef8(ExecuteUNKNOWN), MethodRef8(ExecuteUNKNOWN)
+};
+
+// 000200-000277
+const CProcessor::ExecuteMethodRef CProcessor::m_ExecuteMethods0200[64] =
+{
+    MethodRef8(ExecuteRTS),  // RTS / RETURN
+    MethodRef8(ExecuteUNKNOWN), MethodRef8(ExecuteUNKNOWN), MethodRef8(ExecuteUNKNOWN),
+    MethodRef8(ExecuteCCC), MethodRef8(ExecuteCCC),
+    MethodRef8(ExecuteSCC), MethodRef8(ExecuteSCC)
+};
+
+CProcessor::ExecuteMethodRef CProcessor::GetExecuteMethod(uint16_t instruction)
+{
+    ExecuteMethodRef methodref = m_ExecuteMethodBlocks[instruction >> 6];
+    if (methodref != nullptr)
+        return methodref;
+
+    switch (instruction >> 6)
+    {
+    case 0000:
+        return m_ExecuteMethods0000[instruction & 077];
+    case 0002:
+        return m_ExecuteMethods0200[instruction & 077];
+    case 0750:  // 075000-075037 FIS
+        return (instruction & 040) == 0 ? &CProcessor::ExecuteFIS : &CProcessor::ExecuteUNKNOWN;
+    }
+
+    return &CProcessor::ExecuteUNKNOWN;  // Not reached: the other blocks have their methods
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -335,22 +298,35 @@ CProcessor::CProcessor(CMotherboard* pBoard)
 
     memset(m_R, 0, sizeof(m_R));
     m_psw = m_savepsw = 0777;
+    m_lazyop = LAZYPSW_NONE;  m_lazysave = false;
+    m_lazya = m_lazyb = m_lazyres = 0;
     m_savepc = 0177777;
     m_okStopped = true;
     m_internalTick = 0;
+    m_ticks = m_tickTarget = 0;
     m_waitmode = false;
+    m_okFISNative = false;
+    m_FIStiming = FIS_NATIVE_TIMING;
+    m_fixedTiming = 0;
     m_stepmode = false;
     m_buserror = false;
-    m_STRTrq = m_RPLYrq = m_RSVDrq = m_TBITrq = m_ACLOrq = m_HALTrq = m_EVNTrq = false;
-    m_ILLGrq = m_FIS_rq = m_BPT_rq = m_IOT_rq = m_EMT_rq = m_TRAPrq = m_VIRQrq = false;
+    m_intrq = 0;
     m_ACLOreset = m_EVNTreset = false;
     m_DCLOpin = m_ACLOpin = true;
-    m_haltpin = false;
 
     m_instruction = m_instructionpc = 0;
     m_regsrc = m_methsrc = 0;
     m_regdest = m_methdest = 0;
     m_addrsrc = m_addrdest = 0;
+
+    FlushDecoded();
+    m_pdecoded = &m_decodedtemp;
+
+    m_pollpc = 1;
+    m_polltick = 0;
+    memset(m_pollR, 0, sizeof(m_pollR));
+    m_pollpsw = 0;
+    m_pollskipped = 0;
 }
 
 void CProcessor::Execute()
@@ -367,120 +343,337 @@ void CProcessor::Execute()
         CommandExecution();
 }
 
-bool CProcessor::InterruptProcessing()
+// Equivalent of calling Execute() once per tick, but the ticks spent inside an instruction are skipped at once
+bool CProcessor::RunUntil(uint64_t target)
 {
-    uint16_t intrVector = 0xFFFF;
-    bool currMode = ((m_psw & 0400) != 0);  // Current processor mode: true = HALT mode, false = USER mode
-    bool intrMode = false;  // true = HALT mode interrupt, false = USER mode interrupt
-
-    if (m_stepmode)
-    {
-        m_stepmode = false;
-        return false;
-    }
-
-    m_ACLOreset = m_EVNTreset = false;
-    m_TBITrq = (m_psw & 020) != 0;  // T-bit
-
-    if (m_STRTrq)
-    {
-        intrVector = 0; intrMode = true;
-        m_STRTrq = false;
-    }
-    else if (m_HALTrq)  // HALT command
-    {
-        intrVector = 0170;  intrMode = true;
-        m_HALTrq = false;
-    }
-    else if (m_BPT_rq)  // BPT command
+    m_tickTarget = target;
+    m_pollpc = 1;  // Device state could change since the last call, forget the polling loop pass
+    while (m_ticks < m_tickTarget)
     {
-        intrVector = 0000014;  intrMode = false;
-        m_BPT_rq = false;
-    }
-    else if (m_IOT_rq)  // IOT command
-    {
-        intrVector = 0000020;  intrMode = false;
-        m_IOT_rq = false;
-    }
-    else if (m_EMT_rq)  // EMT command
-    {
-        intrVector = 0000030;  intrMode = false;
-        m_EMT_rq = false;
-    }
-    else if (m_TRAPrq)  // TRAP command
-    {
-        intrVector = 0000034;  intrMode = false;
-        m_TRAPrq = false;
-    }
-    else if (m_FIS_rq)  // FIS commands -- Floating point Instruction Set
-    {
-        intrVector = 0010;  intrMode = true;
-        m_FIS_rq = false;
-    }
-    else if (m_RPLYrq)  // Зависание, priority 1
-    {
-        if (m_buserror)
+        if (m_okStopped)  // Processor is stopped - nothing to do
         {
-            intrVector = 0174; intrMode = true;
+            m_ticks = m_tickTarget;
+            break;
         }
-        else if (currMode)
+
+        uint64_t start = m_ticks + m_internalTick;  // Tick when the next instruction starts
+        if (start >= m_tickTarget)
         {
-            intrVector = 0004;  intrMode = true;
+            m_internalTick -= (uint16_t)(m_tickTarget - m_ticks);
+            m_ticks = m_tickTarget;
+            break;
         }
+        m_internalTick = 0;
+        m_ticks = start;  // Devices see the tick of the current instruction
+
+#if !defined(PRODUCT)
+        if ((m_pBoard->GetTrace() & TRACE_CPU) != 0)
+            TraceInstruction(this, m_pBoard, GetPC() & ~1);
+#endif
+
+        bool okInterrupt = InterruptProcessing();
+        if (!okInterrupt)
+            CommandExecution();
         else
+            m_pollpc = 1;  // The handler time is not a polling loop pass
+        if (m_fixedTiming != 0)
+            m_internalTick = m_fixedTiming;
+        m_ticks++;
+
+        if (!m_pBoard->InstructionDone())
+            return false;
+
+        // WAIT with no interrupt to take: nothing changes until the next device event, skip the idle ticks
+        if (m_waitmode)
         {
-            intrVector = 0000004; intrMode = false;
+            if (m_ticks < m_tickTarget && !IsInterruptPending())
+                m_ticks = m_tickTarget;
         }
-        m_buserror = true;
-        m_RPLYrq = false;
-    }
-    else if (m_ILLGrq)
-    {
-        intrVector = 000004;  intrMode = false;
-        m_ILLGrq = false;
+        // Branch taken back by 1..8 words
+        else if (!okInterrupt && (m_instruction & 0074000) == 0 && (m_instruction & 0103400) != 0 &&
+                 (m_instruction & 0377) >= 0370 && GetPC() <= m_instructionpc)
+            CheckPollingLoop();
+        // SOB Rn back by one word
+        else if (!okInterrupt && (m_instruction & 0177077) == 0077002 && GetPC() == (uint16_t)(m_instructionpc - 2))
+            ExecuteBlockCopy();
     }
-    else if (m_RSVDrq)  // Reserved command, priority 2
-    {
-        intrVector = 000010;  intrMode = false;
-        m_RSVDrq = false;
-    }
-    else if (m_TBITrq && (!m_waitmode))  // T-bit, priority 3
+
+    return true;
+}
+
+// Superinstruction for the block copy loop "1$: MOV (Rs)+,(Rd)+ / SOB Rn,1$", called when SOB goes back to MOV.
+// The passes but the last one are done at once, on plain RAM/ROM only, up to the next board event. Nothing but
+// the loop runs meanwhile, so registers, memory, flags and ticks end up the same as after one by one execution.
+void CProcessor::ExecuteBlockCopy()
+{
+    uint16_t pc = GetPC();
+    bool okHaltMode = IsHaltMode();
+    const uint8_t* pmov = m_pBoard->GetReadPointer(pc, okHaltMode);
+    if (pmov == nullptr)
+        return;
+    uint16_t mov = *((const uint16_t*)pmov);
+    int regsrc = (mov >> 6) & 7, regdest = mov & 7, regcount = (m_instruction >> 6) & 7;
+    if ((mov & 0177070) != 0012020 || regsrc >= 6 || regdest >= 6 ||
+        regsrc == regdest || regcount == regsrc || regcount == regdest)
+        return;
+    if (m_stepmode || IsInterruptPending() || m_pBoard->IsCPUBreakpoint(m_instructionpc, okHaltMode))
+        return;
+#if !defined(PRODUCT)
+    if ((m_pBoard->GetTrace() & TRACE_CPU) != 0)
+        return;
+#endif
+
+    // Passes with SOB starting before the target; the last pass, SOB falling through, goes the usual way
+    uint16_t movticks = (m_fixedTiming != 0) ? m_fixedTiming + 1 : GetInstructionTiming12x12(MOV_TIMING, mov);
+    uint64_t period = movticks + ((m_fixedTiming != 0) ? m_fixedTiming : SOB_TIMING) + 1;
+    uint64_t start = m_ticks + m_internalTick;  // Tick when the next MOV starts
+    if (start + movticks >= m_tickTarget)
+        return;
+    uint64_t count = (m_tickTarget - 1 - start - movticks) / period + 1;
+    if (count > (uint64_t)(m_R[regcount] - 1))
+        count = m_R[regcount] - 1;
+
+    const uint8_t* psob = m_pBoard->GetReadPointer(m_instructionpc, okHaltMode);
+    uint16_t word = 0;
+    uint64_t done = 0;
+    while (done < count)
+    {
+        uint16_t src = m_R[regsrc], dst = m_R[regdest];
+        if (((src | dst) & 1) != 0)
+            break;
+        const uint8_t* psrc = m_pBoard->GetReadPointer(src, okHaltMode);
+        uint8_t* pdst = m_pBoard->GetWritePointer(dst, okHaltMode);
+        if (psrc == nullptr || pdst == nullptr || pdst == pmov || pdst == psob)
+            break;  // Not plain memory, or the loop overwrites itself
+        word = *((const uint16_t*)psrc);
+        *((uint16_t*)pdst) = word;
+        m_pBoard->CheckCodeWrite(m_pBoard->GetRAMOffset(pdst));
+        m_R[regsrc] = src + 2;
+        m_R[regdest] = dst + 2;
+        m_R[regcount]--;
+        done++;
+    }
+    if (done == 0)
+        return;
+
+    SetLazyPSW(LAZYPSW_LOGIC, GetC(), 0, word);
+    m_ticks += done * period;
+}
+
+// Polling loop: a short loop reading only stable locations (see CMotherboard::IsReadStable) and changing nothing
+// but registers and flags. If two passes end in the same state, with no device event in between, every next pass
+// gives the same state up to the next event. So whole passes are skipped by advancing the ticks counter, the loop
+// exits on the same tick as if it was executed.
+void CProcessor::CheckPollingLoop()
+{
+    uint16_t psw = GetPSW();
+    if (m_pollpc != m_instructionpc || m_pollpsw != psw || memcmp(m_pollR, m_R, sizeof(m_R)) != 0)
     {
-        intrVector = 000014;  intrMode = false;
-        m_TBITrq = false;
+        m_pollpc = m_instructionpc;
+        m_polltick = m_ticks;
+        memcpy(m_pollR, m_R, sizeof(m_R));
+        m_pollpsw = psw;
+        return;
     }
-    else if (m_ACLOrq && (m_psw & 0600) != 0600)  // ACLO, priority 4
+
+    uint64_t period = m_ticks - m_polltick;
+    m_polltick = m_ticks;
+    // Passes which branch before the target; the branch starts one tick before m_ticks
+    uint64_t count = (m_tickTarget - m_ticks) / period;
+    if (count == 0 || m_stepmode || IsInterruptPending() || !IsPollingLoopPure(GetPC(), m_instructionpc))
+        return;
+
+    m_ticks += count * period;
+    m_pollskipped += count * period;
+}
+
+// Check the loop body from address up to the branch: only TST/CMP/BIT and MOV to register, with stable operands
+bool CProcessor::IsPollingLoopPure(uint16_t address, uint16_t end) const
+{
+    bool okHaltMode = IsHaltMode();
+    while (address != end)
     {
-        intrVector = 000024;  intrMode = false;
-        m_ACLOreset = true;
+        int addrtype;
+        uint16_t instr = m_pBoard->GetWordView(address, okHaltMode, true, &addrtype);
+        if (addrtype > ADDRTYPE_ROM)
+            return false;
+        address += 2;
+
+        int methsrc = (instr >> 9) & 7, regsrc = (instr >> 6) & 7;
+        int methdest = (instr >> 3) & 7, regdest = instr & 7;
+        switch (instr & 0170000)
+        {
+        case 0010000: case 0110000:  // MOV, MOVB to register except PC
+            if (methdest != 0 || regdest == 7 || !IsPollOperandStable(methsrc, regsrc, address))
+                return false;
+            break;
+        case 0020000: case 0120000:  // CMP, CMPB
+        case 0030000: case 0130000:  // BIT, BITB
+            if (!IsPollOperandStable(methsrc, regsrc, address) || !IsPollOperandStable(methdest, regdest, address))
+                return false;
+            break;
+        case 0000000: case 0100000:  // TST, TSTB
+            if ((instr & 0077700) != 0005700 || !IsPollOperandStable(methdest, regdest, address))
+                return false;
+            break;
+        default:
+            return false;
+        }
+        if (address > end)
+            return false;
     }
-    else if (m_haltpin && (m_psw & 0400) != 0400)  // HALT signal in USER mode, priority 5
+    return true;
+}
+
+// Check the operand read; address points to the index word if any, and is advanced past it
+bool CProcessor::IsPollOperandStable(int meth, int reg, uint16_t& address) const
+{
+    bool okHaltMode = IsHaltMode();
+    uint16_t operand;
+    int addrtype;
+    switch (meth)
     {
-        intrVector = 0170;  intrMode = true;
-    }
-    else if (m_EVNTrq && (m_psw & 0200) != 0200)  // EVNT signal, priority 6
+    case 0:  // Rn
+        return true;
+    case 1:  // @Rn
+        if (reg == 7) return false;
+        return m_pBoard->IsReadStable(m_R[reg], okHaltMode);
+    case 2:  // #nnn
+        if (reg != 7) return false;  // Autoincrement changes the register
+        address += 2;
+        return true;
+    case 3:  // @#nnn
+        if (reg != 7) return false;
+        operand = m_pBoard->GetWordView(address, okHaltMode, true, &addrtype);
+        address += 2;
+        return addrtype <= ADDRTYPE_ROM && m_pBoard->IsReadStable(operand, okHaltMode);
+    case 6:  // X(Rn)
+    case 7:  // @X(Rn)
+        operand = m_pBoard->GetWordView(address, okHaltMode, true, &addrtype);
+        address += 2;
+        if (addrtype > ADDRTYPE_ROM)
+            return false;
+        operand += (reg == 7) ? address : m_R[reg];
+        if (!m_pBoard->IsReadStable(operand, okHaltMode))
+            return false;
+        if (meth == 6)
+            return true;
+        operand = m_pBoard->GetWordView(operand & ~1, okHaltMode, false, &addrtype);
+        return addrtype <= ADDRTYPE_ROM && m_pBoard->IsReadStable(operand, okHaltMode);
+    }
+    return false;  // Autoincrement/autodecrement change the register
+}
+
+// Requests which can be taken now: T-bit is off in WAIT, ACLO masked by PSW bits 7-8 both set,
+// HALT signal works in USER mode only, EVNT and VIRQ masked by PSW bit 7
+uint16_t CProcessor::GetInterruptMask() const
+{
+    uint16_t mask = 0xffff;
+    if (m_waitmode)
+        mask &= ~INTRQ_TBIT;
+    if ((m_psw & 0600) == 0600)
+        mask &= ~INTRQ_ACLO;
+    if ((m_psw & 0400) != 0)
+        mask &= ~INTRQ_HALTPIN;
+    if ((m_psw & 0200) != 0)
+        mask &= ~(INTRQ_EVNT | INTRQ_VIRQ);
+    return mask;
+}
+
+// Number of the highest bit set, the word is not zero
+static int GetHighestBit(uint16_t word)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, word);
+    return (int)index;
+#else
+    return 31 - __builtin_clz(word);
+#endif
+}
+
+bool CProcessor::IsInterruptPending() const
+{
+    uint16_t intrq = m_intrq & ~INTRQ_TBIT;
+    if ((m_psw & 020) != 0)  // T-bit
+        intrq |= INTRQ_TBIT;
+    return (intrq & GetInterruptMask()) != 0;
+}
+
+bool CProcessor::InterruptProcessing()
+{
+    // Vector and mode for every INTRQ_Xxx bit, true = HALT mode interrupt, false = USER mode interrupt
+    static const struct { uint16_t vector; bool mode; } intrVectors[15] =
+    {
+        { 0000274, true  },  // VIRQ, priority 7 -- special case just for PK11/16
+        { 0000100, false },  // EVNT signal, priority 6
+        { 0000170, true  },  // HALT signal in USER mode, priority 5
+        { 0000024, false },  // ACLO, priority 4
+        { 0000014, false },  // T-bit, priority 3
+        { 0000010, false },  // Reserved command, priority 2
+        { 0000004, false },  // Illegal instruction
+        { 0000004, false },  // Зависание, priority 1 -- the vector depends on the mode
+        { 0000010, true  },  // FIS commands -- Floating point Instruction Set
+        { 0000034, false },  // TRAP command
+        { 0000030, false },  // EMT command
+        { 0000020, false },  // IOT command
+        { 0000014, false },  // BPT command
+        { 0000170, true  },  // HALT command
+        { 0000000, true  },  // Start
+    };
+
+    if (m_stepmode)
     {
-        intrVector = 0000100;  intrMode = false;
-        m_EVNTreset = true;
+        m_stepmode = false;
+        return false;
     }
-    else if (m_VIRQrq && (m_psw & 0200) != 0200)  // VIRQ, priority 7
-    {
-        //NOTE: Special case just for PK11/16
 
-        SetHALT(false);
-        SetSP(GetSP() - 2);
-        SetWord(GetSP(), GetCPSW());
-        SetSP(GetSP() - 2);
-        SetWord(GetSP(), GetCPC());
-        if (m_RPLYrq) return true;
+    m_ACLOreset = m_EVNTreset = false;
+    if ((m_psw & 020) != 0)  // T-bit
+        m_intrq |= INTRQ_TBIT;
+    else
+        m_intrq &= ~INTRQ_TBIT;
 
-        m_internalTick += 54;
+    uint16_t intrq = m_intrq & GetInterruptMask();
+    if (intrq != 0)
+    {
+        int intrBit = GetHighestBit(intrq);
+        uint16_t intrVector = intrVectors[intrBit].vector;
+        bool intrMode = intrVectors[intrBit].mode;
+        switch (1 << intrBit)
+        {
+        case INTRQ_RPLY:
+            if (m_buserror)
+            {
+                intrVector = 0174; intrMode = true;
+            }
+            else if ((m_psw & 0400) != 0)  // HALT mode
+                intrMode = true;
+            m_buserror = true;
+            m_intrq &= ~INTRQ_RPLY;
+            break;
+        case INTRQ_ACLO:
+            m_ACLOreset = true;
+            break;
+        case INTRQ_EVNT:
+            m_EVNTreset = true;
+            break;
+        case INTRQ_HALTPIN:  // Signal lines are not reset here
+            break;
+        case INTRQ_VIRQ:
+            SetHALT(false);
+            SetSP(GetSP() - 2);
+            SetWord(GetSP(), GetCPSW());
+            SetSP(GetSP() - 2);
+            SetWord(GetSP(), GetCPC());
+            if (m_intrq & INTRQ_RPLY) return true;
 
-        intrVector = 0000274;  intrMode = true;
-    }
+            m_internalTick += 54;
+            break;
+        default:
+            m_intrq &= ~(1 << intrBit);
+        }
 
-    if (intrVector != 0xFFFF)
-    {
         m_internalTick += EMT_TIMING;  //ANYTHING UNKNOWN WILL CAUSE EXCEPTION (EMT)
 
         m_waitmode = false;
@@ -490,13 +683,14 @@ bool CProcessor::InterruptProcessing()
             uint16_t selVector = m_pBoard->GetSelRegister() & 0x0ff00;
             intrVector |= selVector;
             // Save PC/PSW to CPC/CPSW
+            FlushLazyPSW();
             m_savepc = GetPC();
             m_savepsw = GetPSW();
             m_psw |= 0400;
             SetHALT(true);
             uint16_t new_pc = GetWord(intrVector);
             uint16_t new_psw = GetWord(intrVector + 2);
-            if (m_RPLYrq) return true;
+            if (m_intrq & INTRQ_RPLY) return true;
 
             //DebugLogFormat(_T("%c%06ho\tCPU HALT INT vector=%06ho PC=%06ho PSW=%06ho\r\n"), currMode ? _T('H') : _T('U'), GetInstructionPC(), intrVector, new_pc, new_psw);
             SetPSW(new_psw);
@@ -509,15 +703,15 @@ bool CProcessor::InterruptProcessing()
             SetSP(GetSP() - 2);
             SetWord(GetSP(), GetCPSW());
             SetSP(GetSP() - 2);
-            if (m_RPLYrq) return true;
+            if (m_intrq & INTRQ_RPLY) return true;
             SetWord(GetSP(), GetCPC());
-            if (m_RPLYrq) return true;
+            if (m_intrq & INTRQ_RPLY) return true;
 
-            if (m_ACLOreset) m_ACLOrq = false;
-            if (m_EVNTreset) m_EVNTrq = false;
+            if (m_ACLOreset) m_intrq &= ~INTRQ_ACLO;
+            if (m_EVNTreset) m_intrq &= ~INTRQ_EVNT;
             uint16_t new_pc = GetWord(intrVector);
             uint16_t new_psw = GetWord(intrVector + 2);
-            if (m_RPLYrq) return true;
+            if (m_intrq & INTRQ_RPLY) return true;
 
             //DebugLogFormat(_T("%c%06ho\tCPU USER INT vector=%06ho PC=%06ho PSW=%06ho\r\n"), currMode ? _T('H') : _T('U'), GetInstructionPC(), intrVector, new_pc, new_psw);
             SetLPSW((uint8_t)(new_psw & 0xff));
@@ -536,13 +730,13 @@ void CProcessor::CommandExecution()
     {
         m_instructionpc = m_R[7];  // Store address of the current instruction
         FetchInstruction();  // Read next instruction from memory
-        if (!m_RPLYrq)
+        if ((m_intrq & INTRQ_RPLY) == 0)
         {
             m_buserror = false;
             TranslateInstruction();  // Execute next instruction
         }
     }
-    if (m_HALTrq || m_BPT_rq || m_IOT_rq || m_EMT_rq || m_TRAPrq || m_FIS_rq)
+    if (m_intrq & INTRQ_COMMANDS)
         InterruptProcessing();
 }
 
@@ -550,7 +744,7 @@ void CProcessor::TickEVNT()
 {
     if (m_okStopped) return;  // Processor is stopped - nothing to do
 
-    m_EVNTrq = true;
+    m_intrq |= INTRQ_EVNT;
 }
 
 void CProcessor::SetDCLOPin(bool value)
@@ -564,8 +758,7 @@ void CProcessor::SetDCLOPin(bool value)
         m_buserror = false;
         m_waitmode = false;
         m_internalTick = 0;
-        m_RPLYrq = m_RSVDrq = m_TBITrq = m_ACLOrq = m_HALTrq = m_EVNTrq = false;
-        m_ILLGrq = m_FIS_rq = m_BPT_rq = m_IOT_rq = m_EMT_rq = m_TRAPrq = m_VIRQrq = false;
+        m_intrq &= INTRQ_STRT | INTRQ_HALTPIN;
         m_ACLOreset = m_EVNTreset = false;
         m_pBoard->ResetDevices();
     }
@@ -581,23 +774,22 @@ void CProcessor::SetACLOPin(bool value)
         m_stepmode = false;
         m_waitmode = false;
         m_buserror = false;
-        m_RPLYrq = m_RSVDrq = m_TBITrq = m_ACLOrq = m_HALTrq = m_EVNTrq = false;
-        m_ILLGrq = m_FIS_rq = m_BPT_rq = m_IOT_rq = m_EMT_rq = m_TRAPrq = m_VIRQrq = false;
+        m_intrq &= INTRQ_HALTPIN;
         m_ACLOreset = m_EVNTreset = false;
 
         // "Turn On" interrupt processing
-        m_STRTrq = true;
+        m_intrq |= INTRQ_STRT;
     }
     if (!m_okStopped && !m_DCLOpin && !m_ACLOpin && value)
     {
-        m_ACLOrq = true;
+        m_intrq |= INTRQ_ACLO;
     }
     m_ACLOpin = value;
 }
 
 void CProcessor::MemoryError()
 {
-    m_RPLYrq = true;
+    m_intrq |= INTRQ_RPLY;
 }
 
 
@@ -609,20 +801,64 @@ void CProcessor::FetchInstruction()
     uint16_t pc = GetPC();
     //ASSERT((pc & 1) == 0); // it have to be word aligned
 
-    m_instruction = GetWordExec(pc);
+    // Instructions from RAM or ROM are decoded once, then taken from the cache by physical address;
+    // the board invalidates the cache entry on write to the code page
+    uint32_t offset;
+    int addrtype = m_pBoard->TranslateAddress(pc, IsHaltMode(), true, &offset);
+    if (addrtype == ADDRTYPE_RAM || addrtype == ADDRTYPE_RAM2 || addrtype == ADDRTYPE_RAM4 || addrtype == ADDRTYPE_ROM)
+    {
+        bool okRom = (addrtype == ADDRTYPE_ROM);
+        uint32_t key = okRom ? (offset & 0xfffe) | 0x80000001 : (offset & ~1u) | 1;
+        DecodedInstruction* entry = m_decoded + ((key >> 1) & (DECODECACHE_SIZE - 1));
+        if (entry->key != key)
+        {
+            uint16_t instruction = okRom ? m_pBoard->GetROMWord(offset & 0xfffe) : m_pBoard->GetRAMWord(offset & ~1);
+            if (!okRom)
+                m_pBoard->MarkCodePage(offset);
+            DecodeInstruction(entry, instruction);
+            entry->key = key;
+        }
+        m_pdecoded = entry;
+    }
+    else
+    {
+        DecodeInstruction(&m_decodedtemp, GetWordExec(pc));
+        m_pdecoded = &m_decodedtemp;
+    }
+
+    m_instruction = m_pdecoded->instruction;
     SetPC(GetPC() + 2);
 }
 
-void CProcessor::TranslateInstruction()
+void CProcessor::DecodeInstruction(DecodedInstruction* entry, uint16_t instruction)
 {
     // Prepare values to help decode the command
-    m_regdest  = GetDigit(m_instruction, 0);
-    m_methdest = GetDigit(m_instruction, 1);
-    m_regsrc   = GetDigit(m_instruction, 2);
-    m_methsrc  = GetDigit(m_instruction, 3);
+    entry->instruction = instruction;
+    entry->regdest  = GetDigit(instruction, 0);
+    entry->methdest = GetDigit(instruction, 1);
+    entry->regsrc   = GetDigit(instruction, 2);
+    entry->methsrc  = GetDigit(instruction, 3);
 
     // Find command implementation using the command map
-    ExecuteMethodRef methodref = m_pExecuteMethodMap[m_instruction];
+    entry->methodref = GetExecuteMethod(instruction);
+}
+
+void CProcessor::FlushDecoded()
+{
+    for (int i = 0; i < DECODECACHE_SIZE; i++)
+        m_decoded[i].key = 0;
+}
+
+void CProcessor::TranslateInstruction()
+{
+    // The entry can be invalidated by the instruction itself, so take everything now
+    const DecodedInstruction* pdecoded = m_pdecoded;
+    m_regdest  = pdecoded->regdest;
+    m_methdest = pdecoded->methdest;
+    m_regsrc   = pdecoded->regsrc;
+    m_methsrc  = pdecoded->methsrc;
+
+    ExecuteMethodRef methodref = pdecoded->methodref;
     (this->*methodref)();  // Call command implementation method
 }
 
@@ -630,7 +866,7 @@ void CProcessor::ExecuteUNKNOWN ()  // Нет такой инструкции -
 {
     DebugLogFormat(_T("%06ho\tCPU Unknown opcode %06ho\r\n"), GetInstructionPC(), m_instruction);
 
-    m_RSVDrq = true;
+    m_intrq |= INTRQ_RSVD;
 }
 
 
@@ -644,11 +880,11 @@ void CProcessor::ExecuteWAIT ()  // WAIT - Wait for an interrupt
 void CProcessor::ExecuteSTEP()  // ШАГ
 {
     if ((m_psw & PSW_HALT) == 0)  // Эта команда выполняется только в режиме HALT
-        m_RSVDrq = true;
+        m_intrq |= INTRQ_RSVD;
     else
     {
         SetPC(m_savepc);        // СК <- КРСК
-        SetPSW(m_savepsw);      // РСП(8:0) <- КРСП(8:0)
+        SetPSW(GetCPSW());      // РСП(8:0) <- КРСП(8:0)
         m_stepmode = true;
     }
 }
@@ -656,7 +892,7 @@ void CProcessor::ExecuteSTEP()  // ШАГ
 void CProcessor::ExecuteRSEL()  // RSEL / ЧПТ - Чтение безадресного регистра
 {
     if ((m_psw & PSW_HALT) == 0)  // Эта команда выполняется только в режиме HALT
-        m_RSVDrq = true;
+        m_intrq |= INTRQ_RSVD;
     else
     {
         SetReg(0, m_pBoard->GetSelRegister());  // R0 <- (SEL)
@@ -666,31 +902,195 @@ void CProcessor::ExecuteRSEL()  // RSEL / ЧПТ - Чтение безадрес
 void CProcessor::ExecuteFIS()  // Floating point instruction set: FADD, FSUB, FMUL, FDIV
 {
     if (m_pBoard->GetSelRegister() & 0200)  // bit 7 set?
-        m_RSVDrq = true;  // Программа эмуляции FIS отсутствует, прерывание по резервному коду
-    else
-        m_FIS_rq = true;  // Прерывание обработки FIS
+        m_intrq |= INTRQ_RSVD;  // Программа эмуляции FIS отсутствует, прерывание по резервному коду
+    else if (m_okFISNative && ExecuteFISNative())
+        m_internalTick = m_FIStiming;
+    else
+        m_intrq |= INTRQ_FIS;  // Прерывание обработки FIS
+}
+
+// Calculate A op B for FIS command, op = 0 FADD, 1 FSUB, 2 FMUL, 3 FDIV.
+// Follows the ROM FIS routine step by step to get the same bits: zero exponent is not special
+// for FADD/FSUB, no exceptions, overflow and underflow give zero.
+static void FISCalculate(int op, uint16_t bh, uint16_t bl, uint16_t ah, uint16_t al, uint16_t* phi, uint16_t* plo)
+{
+    if (op == 1) bh ^= 0100000;  // FSUB: A + (-B)
+    bool sign = (ah & 0100000) != 0;
+    int expa = (ah >> 7) & 0377;
+    int expb = (bh >> 7) & 0377;
+    int exp;
+    uint32_t m;  // Result mantissa, R2:R3 in the ROM routine
+    uint16_t carry;
+    bool okRound = true;
+    if (op < 2)  // FADD, FSUB: mantissas with hidden bit, shifted left by 1
+    {
+        uint32_t ma = (0x800000 | ((uint32_t)(ah & 0177) << 16) | al) << 1;
+        uint32_t mb = (0x800000 | ((uint32_t)(bh & 0177) << 16) | bl) << 1;
+        if (sign != ((bh & 0100000) != 0)) mb = 0 - mb;
+        int diff = expa - expb;
+        if (diff > 26)  // B is too small, result is A
+        {
+            exp = expa;  m = ma;
+        }
+        else
+        {
+            if (diff < -26)  // A is too small, result is B
+            {
+                exp = expb;  m = mb;
+            }
+            else if (diff >= 0)  // Align B, the carry goes to the low word of A
+            {
+                exp = expa;
+                carry = (diff > 0) ? (uint16_t)((int32_t)mb >> (diff - 1)) & 1 : 0;
+                mb = (uint32_t)((int32_t)mb >> diff);
+                m = mb + ((ma & 0xffff0000) | ((ma + carry) & 0xffff));
+            }
+            else  // Align A, the carry goes to the high word of B
+            {
+                exp = expb;
+                carry = (uint16_t)(ma >> (-diff - 1)) & 1;
+                ma >>= -diff;
+                m = mb + ((uint32_t)carry << 16) + ma;
+            }
+            if (m & 0x80000000)
+            {
+                m = 0 - m;  sign = !sign;
+            }
+        }
+        if ((m & 0x3000000) == 0)  // Normalize to the left, without rounding
+        {
+            exp--;
+            if ((m & 0xffffff) == 0)
+            {
+                *phi = *plo = 0;
+                return;
+            }
+            while ((m & 0x800000) == 0)
+            {
+                exp--;  m <<= 1;
+            }
+            okRound = false;
+        }
+    }
+    else  // FMUL, FDIV: mantissas with hidden bit, zero exponent means zero
+    {
+        sign = sign != ((bh & 0100000) != 0);
+        if (expa == 0 || expb == 0)
+        {
+            *phi = *plo = 0;
+            return;
+        }
+        uint16_t ha = 0200 | (ah & 0177);
+        uint16_t hb = 0200 | (bh & 0177);
+        if (op == 2)  // FMUL: 8x8 high part, 8x15 cross parts, 15x15 low part
+        {
+            exp = expa + expb - 0201;
+            uint32_t lowlow = (uint32_t)(al >> 1) * (bl >> 1);
+            uint16_t highhigh = ha * hb;
+            uint16_t low = (uint16_t)((highhigh & 1) << 15) | (uint16_t)((lowlow >> 15) & 0x7ffe);
+            m = (uint32_t)hb * (al >> 1) + (uint32_t)ha * (bl >> 1) + (((uint32_t)(highhigh >> 1) << 16) | low);
+            m = (uint32_t)((int32_t)m >> 5);
+        }
+        else  // FDIV: divide by 15 high bits of B mantissa, then correct by the next 9 bits
+        {
+            exp = expa - expb + 0200;
+            uint32_t divisor = (((uint32_t)hb << 16) | bl) << 7;
+            uint16_t dhigh = (uint16_t)(divisor >> 16);
+            uint16_t dlow = (uint16_t)((divisor & 0xffff) >> 1);
+            uint32_t dividend = ((uint32_t)ha << 16) | al;
+            uint16_t q1 = (uint16_t)(dividend / dhigh);
+            uint16_t rem1 = (uint16_t)(dividend % dhigh);
+            uint32_t x = (uint32_t)(q1 * 2) * dlow - ((uint32_t)rem1 << 16);
+            int32_t q2 = ((int32_t)x >> 1) / -(int32_t)dhigh;
+            int32_t rem2 = ((int32_t)x >> 1) % -(int32_t)dhigh;
+            uint16_t high = (uint16_t)(q1 + (q2 < 0 ? 0xffff : 0));
+            uint16_t low = (uint16_t)((q2 << 1) | ((rem2 >> 15) & 1));
+            m = ((uint32_t)high << 16) | low;
+        }
+    }
+    if (okRound)  // Shift right by 1, or by 2 if the mantissa is too long, and round by the last bit shifted out
+    {
+        carry = m & 1;
+        m = (uint32_t)((int32_t)m >> 1);
+        bool okShift = (m & 0x1000000) != 0;
+        for (;;)
+        {
+            if (okShift)
+            {
+                exp++;
+                carry = m & 1;
+                m = (uint32_t)((int32_t)m >> 1);
+            }
+            uint32_t low = (m & 0xffff) + carry;
+            uint16_t byte = (uint16_t)(((m >> 16) & 0377) + (low >> 16));
+            m = (m & 0xff000000) | ((uint32_t)(byte & 0377) << 16) | (low & 0xffff);
+            if ((byte & 0400) == 0) break;
+            okShift = true;  carry = 0;  // Rounding overflowed the mantissa
+        }
+    }
+    if (exp & 0xff00)  // Exponent overflow or underflow gives zero
+    {
+        *phi = *plo = 0;
+        return;
+    }
+    uint16_t high = (uint16_t)(m >> 16);
+    high = (uint16_t)((high & 0xff00) | ((high << 1) & 0377) | (exp << 8));
+    *phi = (uint16_t)((sign ? 0100000 : 0) | (high >> 1));
+    *plo = (uint16_t)m;
+}
+
+// Native FIS command; returns false to leave the command to the ROM routine.
+// (R) = B high, 2(R) = B low, 4(R) = A high, 6(R) = A low; result A op B goes to 4(R), R = R + 4.
+bool CProcessor::ExecuteFISNative()
+{
+    int reg = m_instruction & 7;
+    uint16_t addr = GetReg(reg);
+    if (IsHaltMode() || reg == 7 || (addr & 1) != 0)
+        return false;
+    for (int i = 0; i < 8; i += 2)  // Operands should be in RAM, bus errors are up to the ROM routine
+    {
+        uint32_t offset;
+        if (m_pBoard->TranslateAddress(addr + i, false, false, &offset) > ADDRTYPE_RAM4)
+            return false;
+    }
+
+    uint16_t bh = m_pBoard->GetWord(addr, false);
+    uint16_t bl = m_pBoard->GetWord(addr + 2, false);
+    uint16_t ah = m_pBoard->GetWord(addr + 4, false);
+    uint16_t al = m_pBoard->GetWord(addr + 6, false);
+    uint16_t hi, lo;
+    FISCalculate((m_instruction >> 3) & 3, bh, bl, ah, al, &hi, &lo);
+
+    SetReg(reg, addr + 4);
+    m_pBoard->SetWord(addr + 6, false, lo);
+    m_pBoard->SetWord(addr + 4, false, hi);
+    uint8_t new_psw = GetLPSW() & 0xF0;  // V = C = 0
+    if (hi & 0100000) new_psw |= PSW_N;
+    if (hi == 0) new_psw |= PSW_Z;
+    SetLPSW(new_psw);
+    return true;
 }
 
 void CProcessor::ExecuteRUN()  // ПУСК / START
 {
     if ((m_psw & PSW_HALT) == 0)  // Эта команда выполняется только в режиме HALT
-        m_RSVDrq = true;
+        m_intrq |= INTRQ_RSVD;
     else
     {
         SetPC(m_savepc);        // СК <- КРСК
-        SetPSW(m_savepsw);      // РСП(8:0) <- КРСП(8:0)
+        SetPSW(GetCPSW());      // РСП(8:0) <- КРСП(8:0)
     }
 }
 
 void CProcessor::ExecuteHALT ()  // HALT - Останов
 {
-    m_HALTrq = true;
+    m_intrq |= INTRQ_HALT;
 }
 
 void CProcessor::ExecuteRCPC()  // ЧКСК - Чтение регистра копии счётчика команд
 {
     if ((m_psw & PSW_HALT) == 0)  // Эта команда выполняется только в режиме HALT
-        m_RSVDrq = true;
+        m_intrq |= INTRQ_RSVD;
     else
     {
         SetReg(0, m_savepc);        // R0 <- КРСК
@@ -700,17 +1100,17 @@ void CProcessor::ExecuteRCPC()  // ЧКСК - Чтение регистра ко
 void CProcessor::ExecuteRCPS()  // ЧКСП - Чтение регистра копии слова состояния процессора
 {
     if ((m_psw & PSW_HALT) == 0)  // Эта команда выполняется только в режиме HALT
-        m_RSVDrq = true;
+        m_intrq |= INTRQ_RSVD;
     else
     {
-        SetReg(0, m_savepsw);       // R0 <- КРСП
+        SetReg(0, GetCPSW());       // R0 <- КРСП
         m_internalTick = NOP_TIMING;
     }
 }
 void CProcessor::ExecuteWCPC()  // ЗКСК - Запись регистра копии счётчика команд
 {
     if ((m_psw & PSW_HALT) == 0)  // Эта команда выполняется только в режиме HALT
-        m_RSVDrq = true;
+        m_intrq |= INTRQ_RSVD;
     else
     {
         m_savepc = GetReg(0);       // КРСК <- R0
@@ -720,10 +1120,10 @@ void CProcessor::ExecuteWCPC()  // ЗКСК - Запись регистра ко
 void CProcessor::ExecuteWCPS()  // ЗКСП - Запись регистра копии слова состояния процессора
 {
     if ((m_psw & PSW_HALT) == 0)  // Эта команда выполняется только в режиме HALT
-        m_RSVDrq = true;
+        m_intrq |= INTRQ_RSVD;
     else
     {
-        m_savepsw = GetReg(0);      // КРСП <- R0
+        SetCPSW(GetReg(0));         // КРСП <- R0
         m_internalTick = NOP_TIMING;
     }
 }
@@ -732,7 +1132,7 @@ void CProcessor::ExecuteMFUS ()  // ЧЧП, move from user space - Чтение
 {
     if ((m_psw & PSW_HALT) == 0)  // Эта команда выполняется только в режиме HALT
     {
-        m_RSVDrq = true;
+        m_intrq |= INTRQ_RSVD;
         return;
     }
 
@@ -742,7 +1142,7 @@ void CProcessor::ExecuteMFUS ()  // ЧЧП, move from user space - Чтение
     uint16_t word = GetWord(addr);  // Read in USER mode
     SetHALT(true);
     SetReg(5, addr + 2);
-    if (!m_RPLYrq) SetReg(0, word);
+    if ((m_intrq & INTRQ_RPLY) == 0) SetReg(0, word);
 
     m_internalTick = MOV_TIMING[0][2] - 1;
 }
@@ -751,7 +1151,7 @@ void CProcessor::ExecuteMTUS()  // ЗЧП, move to user space - Запись в
 {
     if ((m_psw & PSW_HALT) == 0)  // Эта команда выполняется только в режиме HALT
     {
-        m_RSVDrq = true;
+        m_intrq |= INTRQ_RSVD;
         return;
     }
 
@@ -769,11 +1169,11 @@ void CProcessor::ExecuteRTI()  // RTI - Return from Interrupt - Возврат 
     uint16_t word;
     word = GetWord(GetSP());
     SetSP( GetSP() + 2 );
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
     SetPC(word);  // Pop PC
     word = GetWord ( GetSP() );  // Pop PSW --- saving HALT
     SetSP( GetSP() + 2 );
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
     if (GetPC() < 0160000)
         SetLPSW((uint8_t)(word & 0xff));
     else
@@ -786,11 +1186,11 @@ void CProcessor::ExecuteRTT ()  // RTT - Return from Trace Trap -- Возвра
     uint16_t word;
     word = GetWord(GetSP());
     SetSP( GetSP() + 2 );
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
     SetPC(word);  // Pop PC
     word = GetWord ( GetSP() );  // Pop PSW --- saving HALT
     SetSP( GetSP() + 2 );
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
     if (GetPC() < 0160000)
         SetLPSW((uint8_t)(word & 0xff));
     else
@@ -803,19 +1203,19 @@ void CProcessor::ExecuteRTT ()  // RTT - Return from Trace Trap -- Возвра
 
 void CProcessor::ExecuteBPT ()  // BPT - Breakpoint
 {
-    m_BPT_rq = true;
+    m_intrq |= INTRQ_BPT;
     m_internalTick = BPT_TIMING;
 }
 
 void CProcessor::ExecuteIOT ()  // IOT - I/O trap
 {
-    m_IOT_rq = true;
+    m_intrq |= INTRQ_IOT;
     m_internalTick = EMT_TIMING;
 }
 
 void CProcessor::ExecuteRESET ()  // Reset input/output devices -- Сброс внешних устройств
 {
-    m_EVNTrq = false;
+    m_intrq &= ~INTRQ_EVNT;
     m_pBoard->ResetDevices();  // INIT signal
 
     m_internalTick = RESET_TIMING;
@@ -827,7 +1227,7 @@ void CProcessor::ExecuteRTS ()  // RTS - return from subroutine - Возврат
     SetPC(GetReg(m_regdest));
     word = GetWord(GetSP());
     SetSP(GetSP() + 2);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
     SetReg(m_regdest, word);
     m_internalTick = RTS_TIMING;
 }
@@ -847,14 +1247,14 @@ void CProcessor::ExecuteJMP ()  // JMP - jump: PC = &d (a-mode > 0)
 {
     if (m_methdest == 0)  // Неправильный метод адресации
     {
-        m_ILLGrq = true;
+        m_intrq |= INTRQ_ILLG;
         m_internalTick = EMT_TIMING;
     }
     else
     {
         uint16_t word;
         word = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         SetPC(word);
         m_internalTick = JMP_TIMING[m_methdest - 1];
     }
@@ -869,9 +1269,9 @@ void CProcessor::ExecuteSWAB ()
     if (m_methdest)
     {
         ea = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        dst = GetWord(ea);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        dst = GetWordRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetReg(m_regdest);
@@ -883,7 +1283,7 @@ void CProcessor::ExecuteSWAB ()
     else
         SetReg(m_regdest, dst);
 
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if ((dst & 0200) != 0) new_psw |= PSW_N;
     if ((uint8_t)(dst & 0xff) == 0) new_psw |= PSW_Z;
@@ -898,14 +1298,14 @@ void CProcessor::ExecuteCLR ()  // CLR
     if (m_methdest)
     {
         dst_addr = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         SetWord(dst_addr, 0);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         SetReg(m_regdest, 0);
 
-    SetLPSW((GetLPSW() & 0xF0) | PSW_Z);
+    SetLazyPSW(LAZYPSW_LOGIC, 0, 0, 0);
     m_internalTick = CLR_TIMING[m_methdest];
 }
 
@@ -916,16 +1316,16 @@ void CProcessor::ExecuteCLRB ()  // CLRB
     if (m_methdest)
     {
         dst_addr = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        GetByte(dst_addr);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        GetByteRMW(dst_addr);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
         SetByteRMW(dst_addr, 0);  // RMW write
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         SetLReg(m_regdest, 0);
 
-    SetLPSW((GetLPSW() & 0xF0) | PSW_Z);
+    SetLazyPSW(LAZYPSW_LOGIC | LAZYPSW_BYTE, 0, 0, 0);
     m_internalTick = CLR_TIMING[m_methdest];
 }
 
@@ -938,9 +1338,9 @@ void CProcessor::ExecuteCOM()  // COM
     if (m_methdest)
     {
         ea = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        dst = GetWord(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        dst = GetWordRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetReg(m_regdest);
@@ -951,7 +1351,7 @@ void CProcessor::ExecuteCOM()  // COM
         SetWordRMW(ea, dst);  // RMW write
     else
         SetReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0100000) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -968,9 +1368,9 @@ void CProcessor::ExecuteCOMB()  // COM
     if (m_methdest)
     {
         ea = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        dst = GetByte(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        dst = GetByteRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetLReg(m_regdest);
@@ -981,7 +1381,7 @@ void CProcessor::ExecuteCOMB()  // COM
         SetByteRMW(ea, dst);  // RMW write
     else
         SetLReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0200) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -993,15 +1393,14 @@ void CProcessor::ExecuteCOMB()  // COM
 void CProcessor::ExecuteINC()  // INC - Инкремент
 {
     uint16_t ea = 0;
-    uint8_t new_psw = GetLPSW() & 0xF1;
     uint16_t dst;
 
     if (m_methdest)
     {
         ea = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        dst = GetWord(ea);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        dst = GetWordRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetReg(m_regdest);
@@ -1012,26 +1411,22 @@ void CProcessor::ExecuteINC()  // INC - Инкремент
         SetWordRMW(ea, dst);  // RMW write
     else
         SetReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
-    if (dst & 0100000) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    if (dst == 0100000) new_psw |= PSW_V;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_INC, GetC(), 0, dst);
     m_internalTick = CLR_TIMING[m_methdest];
 }
 void CProcessor::ExecuteINCB()  // INCB - Инкремент
 {
     uint16_t ea = 0;
-    uint8_t new_psw = GetLPSW() & 0xF1;
     uint8_t dst;
 
     if (m_methdest)
     {
         ea = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        dst = GetByte(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        dst = GetByteRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetLReg(m_regdest);
@@ -1042,27 +1437,23 @@ void CProcessor::ExecuteINCB()  // INCB - Инкремент
         SetByteRMW(ea, dst);  // RMW write
     else
         SetLReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
-    if (dst & 0200) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    if (dst == 0200) new_psw |= PSW_V;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_INC | LAZYPSW_BYTE, GetC(), 0, dst);
     m_internalTick = CLR_TIMING[m_methdest];
 }
 
 void CProcessor::ExecuteDEC()  // DEC - Декремент
 {
     uint16_t ea = 0;
-    uint8_t new_psw = GetLPSW() & 0xF1;
     uint16_t dst;
 
     if (m_methdest)
     {
         ea = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        dst = GetWord(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        dst = GetWordRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetReg(m_regdest);
@@ -1073,27 +1464,23 @@ void CProcessor::ExecuteDEC()  // DEC - Декремент
         SetWordRMW(ea, dst);  // RMW write
     else
         SetReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
-    if (dst & 0100000) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    if (dst == 077777) new_psw |= PSW_V;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_DEC, GetC(), 0, dst);
     m_internalTick = CLR_TIMING[m_methdest];
 }
 
 void CProcessor::ExecuteDECB()  // DECB - Декремент
 {
     uint16_t ea = 0;
-    uint8_t new_psw = GetLPSW() & 0xF1;
     uint8_t dst;
 
     if (m_methdest)
     {
         ea = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        dst = GetByte(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        dst = GetByteRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetLReg(m_regdest);
@@ -1104,12 +1491,9 @@ void CProcessor::ExecuteDECB()  // DECB - Декремент
         SetByteRMW(ea, dst);  // RMW write
     else
         SetLReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
-    if (dst & 0200) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    if (dst == 0177) new_psw |= PSW_V;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_DEC | LAZYPSW_BYTE, GetC(), 0, dst);
     m_internalTick = CLR_TIMING[m_methdest];
 }
 
@@ -1122,9 +1506,9 @@ void CProcessor::ExecuteNEG()
     if (m_methdest)
     {
         ea = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        dst = GetWord(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        dst = GetWordRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetReg(m_regdest);
@@ -1135,7 +1519,7 @@ void CProcessor::ExecuteNEG()
         SetWordRMW(ea, dst);  // RMW write
     else
         SetReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0100000) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -1154,9 +1538,9 @@ void CProcessor::ExecuteNEGB()
     if (m_methdest)
     {
         ea = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        dst = GetByte(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        dst = GetByteRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetLReg(m_regdest);
@@ -1167,7 +1551,7 @@ void CProcessor::ExecuteNEGB()
         SetByteRMW(ea, dst);  // RMW write
     else
         SetLReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0200) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -1186,9 +1570,9 @@ void CProcessor::ExecuteADC()
     if (m_methdest)
     {
         ea = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        dst = GetWord(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        dst = GetWordRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetReg(m_regdest);
@@ -1199,7 +1583,7 @@ void CProcessor::ExecuteADC()
         SetWordRMW(ea, dst);  // RMW write
     else
         SetReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0100000) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -1218,9 +1602,9 @@ void CProcessor::ExecuteADCB()  // ADCB
     if (m_methdest)
     {
         ea = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        dst = GetByte(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        dst = GetByteRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetLReg(m_regdest);
@@ -1231,7 +1615,7 @@ void CProcessor::ExecuteADCB()  // ADCB
         SetByteRMW(ea, dst);  // RMW write
     else
         SetLReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0200) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -1250,9 +1634,9 @@ void CProcessor::ExecuteSBC()
     if (m_methdest)
     {
         ea = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        dst = GetWord(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        dst = GetWordRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetReg(m_regdest);
@@ -1263,7 +1647,7 @@ void CProcessor::ExecuteSBC()
         SetWordRMW(ea, dst);  // RMW write
     else
         SetReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0100000) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -1282,9 +1666,9 @@ void CProcessor::ExecuteSBCB()
     if (m_methdest)
     {
         ea = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        dst = GetByte(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        dst = GetByteRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetLReg(m_regdest);
@@ -1295,7 +1679,7 @@ void CProcessor::ExecuteSBCB()
         SetByteRMW(ea, dst);  // RMW write
     else
         SetLReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0200) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -1307,43 +1691,37 @@ void CProcessor::ExecuteSBCB()
 
 void CProcessor::ExecuteTST()  // TST
 {
-    uint8_t new_psw = GetLPSW() & 0xF0;
     uint16_t dst;
 
     if (m_methdest)
     {
         uint16_t ea = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         dst = GetWord(ea);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetReg(m_regdest);
 
-    if (dst & 0100000) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_LOGIC, 0, 0, dst);
     m_internalTick = TST_TIMING[m_methdest];
 }
 
 void CProcessor::ExecuteTSTB()  // TSTB
 {
-    uint8_t new_psw = GetLPSW() & 0xF0;
     uint8_t dst;
 
     if (m_methdest)
     {
         uint16_t ea = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         dst = GetByte(ea);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetLReg(m_regdest);
 
-    if (dst & 0200) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_LOGIC | LAZYPSW_BYTE, 0, 0, dst);
     m_internalTick = TST_TIMING[m_methdest];
 }
 
@@ -1356,9 +1734,9 @@ void CProcessor::ExecuteROR()  // ROR
     if (m_methdest)
     {
         ea = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        src = GetWord(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        src = GetWordRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src = GetReg(m_regdest);
@@ -1369,7 +1747,7 @@ void CProcessor::ExecuteROR()  // ROR
         SetWordRMW(ea, dst);  // RMW write
     else
         SetReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0100000) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -1388,9 +1766,9 @@ void CProcessor::ExecuteRORB()  // RORB
     if (m_methdest)
     {
         ea = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        src = GetByte(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        src = GetByteRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src = GetLReg(m_regdest);
@@ -1401,7 +1779,7 @@ void CProcessor::ExecuteRORB()  // RORB
         SetByteRMW(ea, dst);  // RMW write
     else
         SetLReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0200) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -1420,9 +1798,9 @@ void CProcessor::ExecuteROL()  // ROL
     if (m_methdest)
     {
         ea = GetWordAddr((uint8_t)m_methdest, (uint8_t)m_regdest);
-        if (m_RPLYrq) return;
-        src = GetWord(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        src = GetWordRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src = GetReg(m_regdest);
@@ -1433,7 +1811,7 @@ void CProcessor::ExecuteROL()  // ROL
         SetWordRMW(ea, dst);  // RMW write
     else
         SetReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0100000) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -1452,9 +1830,9 @@ void CProcessor::ExecuteROLB()  // ROLB
     if (m_methdest)
     {
         ea = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        src = GetByte(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        src = GetByteRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src = GetLReg(m_regdest);
@@ -1465,7 +1843,7 @@ void CProcessor::ExecuteROLB()  // ROLB
         SetByteRMW(ea, dst);  // RMW write
     else
         SetLReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0200) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -1484,9 +1862,9 @@ void CProcessor::ExecuteASR()  // ASR
     if (m_methdest)
     {
         ea = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        src = GetWord(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        src = GetWordRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src = GetReg(m_regdest);
@@ -1497,7 +1875,7 @@ void CProcessor::ExecuteASR()  // ASR
         SetWordRMW(ea, dst);  // RMW write
     else
         SetReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0100000) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -1516,9 +1894,9 @@ void CProcessor::ExecuteASRB()  // ASRB
     if (m_methdest)
     {
         ea = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        src = GetByte(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        src = GetByteRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src = GetLReg(m_regdest);
@@ -1529,7 +1907,7 @@ void CProcessor::ExecuteASRB()  // ASRB
         SetByteRMW(ea, dst);  // RMW write
     else
         SetLReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0200) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -1548,9 +1926,9 @@ void CProcessor::ExecuteASL()  // ASL
     if (m_methdest)
     {
         ea = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        src = GetWord(ea);  // RMW write
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        src = GetWordRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src = GetReg(m_regdest);
@@ -1561,7 +1939,7 @@ void CProcessor::ExecuteASL()  // ASL
         SetWordRMW(ea, dst);  // RMW write
     else
         SetReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0100000) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -1580,9 +1958,9 @@ void CProcessor::ExecuteASLB()  // ASLB
     if (m_methdest)
     {
         ea = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        src = GetByte(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        src = GetByteRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src = GetLReg(m_regdest);
@@ -1593,7 +1971,7 @@ void CProcessor::ExecuteASLB()  // ASLB
         SetByteRMW(ea, dst);  // RMW write
     else
         SetLReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0200) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -1609,9 +1987,9 @@ void CProcessor::ExecuteSXT ()  // SXT - sign-extend
     if (m_methdest)
     {
         uint16_t ea = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         SetWord(ea, GetN() ? 0177777 : 0);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         SetReg(m_regdest, GetN() ? 0177777 : 0); //sign extend
@@ -1627,9 +2005,9 @@ void CProcessor::ExecuteMTPS ()  // MTPS - move to PS
     if (m_methdest)
     {
         uint16_t ea = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         dst = GetByte(ea);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetLReg(m_regdest);
@@ -1647,11 +2025,11 @@ void CProcessor::ExecuteMFPS ()  // MFPS - move from PS
     if (m_methdest)
     {
         uint16_t ea = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        GetByte(ea);  // RMW write
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        GetByteRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
         SetByteRMW(ea, psw);  // RMW write
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         SetReg(m_regdest, (uint16_t)(signed short)(char)psw); //sign extend
@@ -1831,9 +2209,9 @@ void CProcessor::ExecuteXOR ()  // XOR
     if (m_methdest)
     {
         ea = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        dst = GetWord(ea);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        dst = GetWordRMW(ea);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetReg(m_regdest);
@@ -1844,7 +2222,7 @@ void CProcessor::ExecuteXOR ()  // XOR
         SetWordRMW(ea, dst);  // RMW write
     else
         SetReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     if (dst & 0100000) new_psw |= PSW_N;
     if (dst == 0) new_psw |= PSW_Z;
@@ -1860,9 +2238,9 @@ void CProcessor::ExecuteMUL()  // MUL - multiply
     uint8_t new_psw = GetLPSW() & 0xF0;
 
     if (m_methdest) ea = GetWordAddr(m_methdest, m_regdest);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
     src = m_methdest ? GetWord(ea) : GetReg(m_regdest);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     res = (signed short)dst * (signed short)src;
 
@@ -1884,9 +2262,9 @@ void CProcessor::ExecuteDIV()  // DIV - divide
     uint8_t new_psw = GetLPSW() & 0xF0;
 
     if (m_methdest) ea = GetWordAddr(m_methdest, m_regdest);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
     src2 = (int)(signed short)(m_methdest ? GetWord(ea) : GetReg(m_regdest));
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     longsrc = (int32_t)(((uint32_t)GetReg(m_regsrc | 1)) | ((uint32_t)GetReg(m_regsrc) << 16));
 
@@ -1931,9 +2309,9 @@ void CProcessor::ExecuteASH()  // ASH - arithmetic shift
     uint8_t new_psw = GetLPSW() & 0xF0;
 
     if (m_methdest) ea = GetWordAddr(m_methdest, m_regdest);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
     src = (short)(m_methdest ? GetWord(ea) : GetReg(m_regdest));
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
     src &= 0x3F;
     src |= (src & 040) ? 0177700 : 0;
     dst = (short)GetReg(m_regsrc);
@@ -1975,9 +2353,9 @@ void CProcessor::ExecuteASHC()  // ASHC - arithmetic shift combined
     uint8_t new_psw = GetLPSW() & 0xF0;
 
     if (m_methdest) ea = GetWordAddr(m_methdest, m_regdest);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
     src = (int16_t)(m_methdest ? GetWord(ea) : GetReg(m_regdest));
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
     src &= 0x3F;
     src |= (src & 040) ? 0177700 : 0;
     dst = ((uint32_t)GetReg(m_regsrc | 1)) | ((uint32_t)GetReg(m_regsrc) << 16);
@@ -2030,15 +2408,14 @@ void CProcessor::ExecuteSOB()  // SOB - subtract one: R = R - 1 ; if R != 0 : PC
 void CProcessor::ExecuteMOV()  // MOV - move
 {
     uint16_t src_addr, dst_addr;
-    uint8_t new_psw = GetLPSW() & 0xF1;
     uint16_t dst;
 
     if (m_methsrc)
     {
         src_addr = GetWordAddr(m_methsrc, m_regsrc);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         dst = GetWord(src_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetReg(m_regsrc);
@@ -2046,16 +2423,14 @@ void CProcessor::ExecuteMOV()  // MOV - move
     if (m_methdest)
     {
         dst_addr = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         SetWord(dst_addr, dst);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         SetReg(m_regdest, dst);
 
-    if (dst & 0100000) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_LOGIC, GetC(), 0, dst);
 
     m_internalTick = GetInstructionTiming12x12(MOV_TIMING, m_instruction) - 1;
 }
@@ -2063,15 +2438,14 @@ void CProcessor::ExecuteMOV()  // MOV - move
 void CProcessor::ExecuteMOVB()  // MOVB - move byte
 {
     uint16_t src_addr, dst_addr;
-    uint8_t new_psw = GetLPSW() & 0xF1;
     uint8_t dst;
 
     if (m_methsrc)
     {
         src_addr = GetByteAddr(m_methsrc, m_regsrc);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         dst = GetByte(src_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         dst = GetLReg(m_regsrc);
@@ -2079,18 +2453,16 @@ void CProcessor::ExecuteMOVB()  // MOVB - move byte
     if (m_methdest)
     {
         dst_addr = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        GetByte(dst_addr);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        GetByteRMW(dst_addr);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
         SetByteRMW(dst_addr, dst);  // RMW write
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         SetReg(m_regdest, (uint16_t)(signed short)(char)dst);
 
-    if (dst & 0200) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_LOGIC | LAZYPSW_BYTE, GetC(), 0, dst);
 
     m_internalTick = GetInstructionTiming12x12(MOVB_TIMING, m_instruction) - 1;
 }
@@ -2098,7 +2470,6 @@ void CProcessor::ExecuteMOVB()  // MOVB - move byte
 void CProcessor::ExecuteCMP()  // CMP - compare
 {
     uint16_t src_addr, dst_addr;
-    uint8_t new_psw = GetLPSW() & 0xF0;
 
     uint16_t src;
     uint16_t src2;
@@ -2107,9 +2478,9 @@ void CProcessor::ExecuteCMP()  // CMP - compare
     if (m_methsrc)
     {
         src_addr = GetWordAddr(m_methsrc, m_regsrc);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         src = GetWord(src_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src = GetReg(m_regsrc);
@@ -2117,20 +2488,16 @@ void CProcessor::ExecuteCMP()  // CMP - compare
     if (m_methdest)
     {
         dst_addr = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         src2 = GetWord(dst_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src2 = GetReg(m_regdest);
 
     dst = src - src2;
 
-    if (dst & 0100000) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    if (((src ^ src2) & ~(dst ^ src2)) & 0100000) new_psw |= PSW_V;
-    if (((~src & src2) | (~(src ^ src2) & dst)) & 0100000) new_psw |= PSW_C;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_SUB, src, src2, dst);
 
     m_internalTick = GetInstructionTiming12x12(BIT_TIMING, m_instruction) - 1;
 }
@@ -2138,7 +2505,6 @@ void CProcessor::ExecuteCMP()  // CMP - compare
 void CProcessor::ExecuteCMPB()  // CMPB - compare byte
 {
     uint16_t src_addr, dst_addr;
-    uint8_t new_psw = GetLPSW() & 0xF0;
 
     uint8_t src;
     uint8_t src2;
@@ -2147,9 +2513,9 @@ void CProcessor::ExecuteCMPB()  // CMPB - compare byte
     if (m_methsrc)
     {
         src_addr = GetByteAddr(m_methsrc, m_regsrc);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         src = GetByte(src_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src = GetLReg(m_regsrc);
@@ -2157,20 +2523,16 @@ void CProcessor::ExecuteCMPB()  // CMPB - compare byte
     if (m_methdest)
     {
         dst_addr = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         src2 = GetByte(dst_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src2 = GetLReg(m_regdest);
 
     dst = src - src2;
 
-    if (dst & 0200) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    if (((src ^ src2) & ~(dst ^ src2)) & 0200) new_psw |= PSW_V;
-    if (((~src & src2) | (~(src ^ src2) & dst)) & 0200) new_psw |= PSW_C;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_SUB | LAZYPSW_BYTE, src, src2, dst);
 
     m_internalTick = GetInstructionTiming12x12(BITB_TIMING, m_instruction) - 1;
 }
@@ -2178,7 +2540,6 @@ void CProcessor::ExecuteCMPB()  // CMPB - compare byte
 void CProcessor::ExecuteBIT()  // BIT - bit test
 {
     uint16_t src_addr, dst_addr;
-    uint8_t new_psw = GetLPSW() & 0xF1;
     uint16_t src;
     uint16_t src2;
     uint16_t dst;
@@ -2186,9 +2547,9 @@ void CProcessor::ExecuteBIT()  // BIT - bit test
     if (m_methsrc)
     {
         src_addr = GetWordAddr(m_methsrc, m_regsrc);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         src = GetWord(src_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src  = GetReg(m_regsrc);
@@ -2196,18 +2557,16 @@ void CProcessor::ExecuteBIT()  // BIT - bit test
     if (m_methdest)
     {
         dst_addr = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         src2 = GetWord(dst_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src2 = GetReg(m_regdest);
 
     dst = src2 & src;
 
-    if (dst & 0100000) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_LOGIC, GetC(), 0, dst);
 
     m_internalTick = GetInstructionTiming12x12(BIT_TIMING, m_instruction) - 1;
 }
@@ -2215,7 +2574,6 @@ void CProcessor::ExecuteBIT()  // BIT - bit test
 void CProcessor::ExecuteBITB()  // BITB - bit test on byte
 {
     uint16_t src_addr, dst_addr;
-    uint8_t new_psw = GetLPSW() & 0xF1;
     uint8_t src;
     uint8_t src2;
     uint8_t dst;
@@ -2223,9 +2581,9 @@ void CProcessor::ExecuteBITB()  // BITB - bit test on byte
     if (m_methsrc)
     {
         src_addr = GetByteAddr(m_methsrc, m_regsrc);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         src = GetByte(src_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src = GetLReg(m_regsrc);
@@ -2233,18 +2591,16 @@ void CProcessor::ExecuteBITB()  // BITB - bit test on byte
     if (m_methdest)
     {
         dst_addr = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         src2 = GetByte(dst_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src2 = GetLReg(m_regdest);
 
     dst = src2 & src;
 
-    if (dst & 0200) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_LOGIC | LAZYPSW_BYTE, GetC(), 0, dst);
 
     m_internalTick = GetInstructionTiming12x12(BITB_TIMING, m_instruction) - 1;
 }
@@ -2252,7 +2608,6 @@ void CProcessor::ExecuteBITB()  // BITB - bit test on byte
 void CProcessor::ExecuteBIC()  // BIC - bit clear
 {
     uint16_t src_addr, dst_addr = 0;
-    uint8_t new_psw = GetLPSW() & 0xF1;
     uint16_t src;
     uint16_t src2;
     uint16_t dst;
@@ -2260,9 +2615,9 @@ void CProcessor::ExecuteBIC()  // BIC - bit clear
     if (m_methsrc)
     {
         src_addr = GetWordAddr(m_methsrc, m_regsrc);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         src = GetWord(src_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src  = GetReg(m_regsrc);
@@ -2270,9 +2625,9 @@ void CProcessor::ExecuteBIC()  // BIC - bit clear
     if (m_methdest)
     {
         dst_addr = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        src2 = GetWord(dst_addr);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        src2 = GetWordRMW(dst_addr);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src2 = GetReg(m_regdest);
@@ -2283,11 +2638,9 @@ void CProcessor::ExecuteBIC()  // BIC - bit clear
         SetWordRMW(dst_addr, dst);  // RMW write
     else
         SetReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
-    if (dst & 0100000) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_LOGIC, GetC(), 0, dst);
 
     m_internalTick = GetInstructionTiming12x12(ADD_TIMING, m_instruction) - 1;
 }
@@ -2295,7 +2648,6 @@ void CProcessor::ExecuteBIC()  // BIC - bit clear
 void CProcessor::ExecuteBICB()  // BICB - bit clear
 {
     uint16_t src_addr, dst_addr = 0;
-    uint8_t new_psw = GetLPSW() & 0xF1;
     uint8_t src;
     uint8_t src2;
     uint8_t dst;
@@ -2303,9 +2655,9 @@ void CProcessor::ExecuteBICB()  // BICB - bit clear
     if (m_methsrc)
     {
         src_addr = GetByteAddr(m_methsrc, m_regsrc);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         src = GetByte(src_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src = GetLReg(m_regsrc);
@@ -2313,9 +2665,9 @@ void CProcessor::ExecuteBICB()  // BICB - bit clear
     if (m_methdest)
     {
         dst_addr = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        src2 = GetByte(dst_addr);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        src2 = GetByteRMW(dst_addr);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src2 = GetLReg(m_regdest);
@@ -2326,11 +2678,9 @@ void CProcessor::ExecuteBICB()  // BICB - bit clear
         SetByteRMW(dst_addr, dst);  // RMW write
     else
         SetLReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
-    if (dst & 0200) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_LOGIC | LAZYPSW_BYTE, GetC(), 0, dst);
 
     m_internalTick = GetInstructionTiming12x12(MOVB_TIMING, m_instruction) - 1;
 }
@@ -2338,7 +2688,6 @@ void CProcessor::ExecuteBICB()  // BICB - bit clear
 void CProcessor::ExecuteBIS()  // BIS - bit set
 {
     uint16_t src_addr, dst_addr = 0;
-    uint8_t new_psw = GetLPSW() & 0xF1;
     uint16_t src;
     uint16_t src2;
     uint16_t dst;
@@ -2346,9 +2695,9 @@ void CProcessor::ExecuteBIS()  // BIS - bit set
     if (m_methsrc)
     {
         src_addr = GetWordAddr(m_methsrc, m_regsrc);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         src = GetWord(src_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src  = GetReg(m_regsrc);
@@ -2356,9 +2705,9 @@ void CProcessor::ExecuteBIS()  // BIS - bit set
     if (m_methdest)
     {
         dst_addr = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        src2 = GetWord(dst_addr);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        src2 = GetWordRMW(dst_addr);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src2 = GetReg(m_regdest);
@@ -2369,11 +2718,9 @@ void CProcessor::ExecuteBIS()  // BIS - bit set
         SetWordRMW(dst_addr, dst);  // RMW write
     else
         SetReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
-    if (dst & 0100000) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_LOGIC, GetC(), 0, dst);
 
     m_internalTick = GetInstructionTiming12x12(ADD_TIMING, m_instruction) - 1;
 }
@@ -2381,7 +2728,6 @@ void CProcessor::ExecuteBIS()  // BIS - bit set
 void CProcessor::ExecuteBISB()  // BISB - bit set on byte
 {
     uint16_t src_addr, dst_addr = 0;
-    uint8_t new_psw = GetLPSW() & 0xF1;
     uint8_t src;
     uint8_t src2;
     uint8_t dst;
@@ -2389,9 +2735,9 @@ void CProcessor::ExecuteBISB()  // BISB - bit set on byte
     if (m_methsrc)
     {
         src_addr = GetByteAddr(m_methsrc, m_regsrc);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         src = GetByte(src_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src = GetLReg(m_regsrc);
@@ -2399,9 +2745,9 @@ void CProcessor::ExecuteBISB()  // BISB - bit set on byte
     if (m_methdest)
     {
         dst_addr = GetByteAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        src2 = GetByte(dst_addr);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        src2 = GetByteRMW(dst_addr);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src2 = GetLReg(m_regdest);
@@ -2412,27 +2758,24 @@ void CProcessor::ExecuteBISB()  // BISB - bit set on byte
         SetByteRMW(dst_addr, dst);  // RMW write
     else
         SetLReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
-    if (dst & 0200) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_LOGIC | LAZYPSW_BYTE, GetC(), 0, dst);
 
     m_internalTick = GetInstructionTiming12x12(MOVB_TIMING, m_instruction) - 1;
 }
 
-void CProcessor::ExecuteADD ()  // ADD
+void CProcessor::ExecuteADD()  // ADD
 {
     uint16_t src_addr, dst_addr = 0;
-    uint8_t new_psw = GetLPSW() & 0xF0;
     uint16_t src, src2, dst;
 
     if (m_methsrc)
     {
         src_addr = GetWordAddr(m_methsrc, m_regsrc);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         src = GetWord(src_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src = GetReg(m_regsrc);
@@ -2440,9 +2783,9 @@ void CProcessor::ExecuteADD ()  // ADD
     if (m_methdest)
     {
         dst_addr = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        src2 = GetWord(dst_addr);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        src2 = GetWordRMW(dst_addr);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src2 = GetReg(m_regdest);
@@ -2453,13 +2796,9 @@ void CProcessor::ExecuteADD ()  // ADD
         SetWordRMW(dst_addr, dst);  // RMW write
     else
         SetReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
-    if (dst & 0100000) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    if ((~(src ^ src2) & (dst ^ src2)) & 0100000) new_psw |= PSW_V;
-    if (((src & src2) | ((src ^ src2) & ~dst)) & 0100000) new_psw |= PSW_C;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_ADD, src, src2, dst);
 
     m_internalTick = GetInstructionTiming12x12(ADD_TIMING, m_instruction) - 1;
 }
@@ -2467,15 +2806,14 @@ void CProcessor::ExecuteADD ()  // ADD
 void CProcessor::ExecuteSUB()  // SUB
 {
     uint16_t src_addr, dst_addr = 0;
-    uint8_t new_psw = GetLPSW() & 0xF0;
     uint16_t src, src2, dst;
 
     if (m_methsrc)
     {
         src_addr = GetWordAddr(m_methsrc, m_regsrc);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
         src = GetWord(src_addr);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src = GetReg(m_regsrc);
@@ -2483,9 +2821,9 @@ void CProcessor::ExecuteSUB()  // SUB
     if (m_methdest)
     {
         dst_addr = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
-        src2 = GetWord(dst_addr);  // RMW read
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
+        src2 = GetWordRMW(dst_addr);  // RMW read
+        if (m_intrq & INTRQ_RPLY) return;
     }
     else
         src2 = GetReg(m_regdest);
@@ -2496,26 +2834,22 @@ void CProcessor::ExecuteSUB()  // SUB
         SetWordRMW(dst_addr, dst);  // RMW write
     else
         SetReg(m_regdest, dst);
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
-    if (dst & 0100000) new_psw |= PSW_N;
-    if (dst == 0) new_psw |= PSW_Z;
-    if (((src ^ src2) & ~(dst ^ src)) & 0100000) new_psw |= PSW_V;
-    if (((src & ~src2) | (~(src ^ src2) & dst)) & 0100000) new_psw |= PSW_C;
-    SetLPSW(new_psw);
+    SetLazyPSW(LAZYPSW_SUB, src2, src, dst);
 
     m_internalTick = GetInstructionTiming12x12(ADD_TIMING, m_instruction) - 1;
 }
 
 void CProcessor::ExecuteEMT()  // EMT - emulator trap
 {
-    m_EMT_rq = true;
+    m_intrq |= INTRQ_EMT;
     m_internalTick = EMT_TIMING;
 }
 
 void CProcessor::ExecuteTRAP()
 {
-    m_TRAPrq = true;
+    m_intrq |= INTRQ_TRAP;
     m_internalTick = EMT_TIMING;
 }
 
@@ -2524,20 +2858,20 @@ void CProcessor::ExecuteJSR()  // JSR - jump subroutine: *--SP = R; R = PC; PC =
     if (m_methdest == 0)
     {
         // Неправильный метод адресации
-        m_ILLGrq = true;
+        m_intrq |= INTRQ_ILLG;
         m_internalTick = EMT_TIMING;
     }
     else
     {
         uint16_t dst;
         dst = GetWordAddr(m_methdest, m_regdest);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
 
         SetSP( GetSP() - 2 );
         SetWord( GetSP(), GetReg(m_regsrc) );
         SetReg(m_regsrc, GetPC());
         SetPC(dst);
-        if (m_RPLYrq) return;
+        if (m_intrq & INTRQ_RPLY) return;
 
         m_internalTick = JSR_TIMING[m_methdest - 1];
     }
@@ -2549,7 +2883,7 @@ void CProcessor::ExecuteMARK ()  // MARK
     SetPC( GetReg(5) );
     SetReg(5, GetWord( GetSP() ));
     SetSP( GetSP() + 2 );
-    if (m_RPLYrq) return;
+    if (m_intrq & INTRQ_RPLY) return;
 
     m_internalTick = MARK_TIMING;
 }
@@ -2570,40 +2904,40 @@ void CProcessor::SaveToImage(uint8_t* pImage) const
 {
     // Processor data                               // Offset Size
     uint16_t* pwImage = (uint16_t*) pImage;         //    0    --
-    *pwImage++ = m_psw;                             //    0     2   PSW
+    *pwImage++ = GetPSW();                          //    0     2   PSW
     memcpy(pwImage, m_R, 2 * 8);  pwImage += 8;     //    2    16   Registers R0-R7
     *pwImage++ = m_savepc;                          //   18     2   PC'
-    *pwImage++ = m_savepsw;                         //   20     2   PSW'
+    *pwImage++ = GetCPSW();                         //   20     2   PSW'
     *pwImage++ = (m_okStopped ? 1 : 0);             //   22     2   Stopped
     *pwImage++ = m_internalTick;                    //   24     2   Internal tick count
     uint8_t* pbImage = (uint8_t*) pwImage;
     uint8_t flags0 = 0;
     flags0 |= (m_stepmode ?   1 : 0);
     flags0 |= (m_buserror ?   2 : 0);
-    flags0 |= (m_haltpin  ?   4 : 0);
+    flags0 |= ((m_intrq & INTRQ_HALTPIN) != 0 ?   4 : 0);
     flags0 |= (m_DCLOpin  ?   8 : 0);
     flags0 |= (m_ACLOpin  ?  16 : 0);
     flags0 |= (m_waitmode ?  32 : 0);
     *pbImage++ = flags0;                            //   26     1   Flags
     uint8_t flags1 = 0;
-    flags1 |= (m_STRTrq ?   1 : 0);
-    flags1 |= (m_RPLYrq ?   2 : 0);
-    flags1 |= (m_ILLGrq ?   4 : 0);
-    flags1 |= (m_RSVDrq ?   8 : 0);
-    flags1 |= (m_TBITrq ?  16 : 0);
-    flags1 |= (m_ACLOrq ?  32 : 0);
-    flags1 |= (m_HALTrq ?  64 : 0);
-    flags1 |= (m_EVNTrq ? 128 : 0);
+    flags1 |= ((m_intrq & INTRQ_STRT) != 0 ?   1 : 0);
+    flags1 |= ((m_intrq & INTRQ_RPLY) != 0 ?   2 : 0);
+    flags1 |= ((m_intrq & INTRQ_ILLG) != 0 ?   4 : 0);
+    flags1 |= ((m_intrq & INTRQ_RSVD) != 0 ?   8 : 0);
+    flags1 |= ((m_intrq & INTRQ_TBIT) != 0 ?  16 : 0);
+    flags1 |= ((m_intrq & INTRQ_ACLO) != 0 ?  32 : 0);
+    flags1 |= ((m_intrq & INTRQ_HALT) != 0 ?  64 : 0);
+    flags1 |= ((m_intrq & INTRQ_EVNT) != 0 ? 128 : 0);
     *pbImage++ = flags1;                            //   27     1   Flags
     uint8_t flags2 = 0;
-    flags2 |= (m_FIS_rq ?   1 : 0);
-    flags2 |= (m_BPT_rq ?   2 : 0);
-    flags2 |= (m_IOT_rq ?   4 : 0);
-    flags2 |= (m_EMT_rq ?   8 : 0);
-    flags2 |= (m_TRAPrq ?  16 : 0);
+    flags2 |= ((m_intrq & INTRQ_FIS) != 0 ?   1 : 0);
+    flags2 |= ((m_intrq & INTRQ_BPT) != 0 ?   2 : 0);
+    flags2 |= ((m_intrq & INTRQ_IOT) != 0 ?   4 : 0);
+    flags2 |= ((m_intrq & INTRQ_EMT) != 0 ?   8 : 0);
+    flags2 |= ((m_intrq & INTRQ_TRAP) != 0 ?  16 : 0);
     flags2 |= (m_ACLOreset ? 32 : 0);
     flags2 |= (m_EVNTreset ? 64 : 0);
-    flags2 |= (m_VIRQrq ? 128 : 0);
+    flags2 |= ((m_intrq & INTRQ_VIRQ) != 0 ? 128 : 0);
     *pbImage++ = flags2;                            //   28     1   Flags
     //                                              //   29    35   Reserved
 }
@@ -2611,6 +2945,7 @@ void CProcessor::SaveToImage(uint8_t* pImage) const
 void CProcessor::LoadFromImage(const uint8_t* pImage)
 {
     const uint16_t* pwImage = (const uint16_t*) pImage;  //    0    --
+    m_lazyop = LAZYPSW_NONE;
     m_psw = *pwImage++;                             //    0     2   PSW
     memcpy(m_R, pwImage, 2 * 8);  pwImage += 8;     //    2    16   Registers R0-R7
     m_savepc    = *pwImage++;                       //   18     2   PC'
@@ -2621,28 +2956,29 @@ void CProcessor::LoadFromImage(const uint8_t* pImage)
     uint8_t flags0 = *pbImage++;                    //   26     1   Flags
     m_stepmode  = ((flags0 &  1) != 0);
     m_buserror  = ((flags0 &  2) != 0);
-    m_haltpin   = ((flags0 &  4) != 0);
     m_DCLOpin   = ((flags0 &  8) != 0);
     m_ACLOpin   = ((flags0 & 16) != 0);
     m_waitmode  = ((flags0 & 32) != 0);
+    m_intrq = 0;
+    if (flags0 &  4) m_intrq |= INTRQ_HALTPIN;
     uint8_t flags1 = *pbImage++;                    //   27     1   Flags
-    m_STRTrq    = ((flags1 &   1) != 0);
-    m_RPLYrq    = ((flags1 &   2) != 0);
-    m_ILLGrq    = ((flags1 &   4) != 0);
-    m_RSVDrq    = ((flags1 &   8) != 0);
-    m_TBITrq    = ((flags1 &  16) != 0);
-    m_ACLOrq    = ((flags1 &  32) != 0);
-    m_HALTrq    = ((flags1 &  64) != 0);
-    m_EVNTrq    = ((flags1 & 128) != 0);
+    if (flags1 &   1) m_intrq |= INTRQ_STRT;
+    if (flags1 &   2) m_intrq |= INTRQ_RPLY;
+    if (flags1 &   4) m_intrq |= INTRQ_ILLG;
+    if (flags1 &   8) m_intrq |= INTRQ_RSVD;
+    if (flags1 &  16) m_intrq |= INTRQ_TBIT;
+    if (flags1 &  32) m_intrq |= INTRQ_ACLO;
+    if (flags1 &  64) m_intrq |= INTRQ_HALT;
+    if (flags1 & 128) m_intrq |= INTRQ_EVNT;
     uint8_t flags2 = *pbImage++;                    //   28     1   Flags
-    m_FIS_rq    = ((flags2 &  1) != 0);
-    m_BPT_rq    = ((flags2 &  2) != 0);
-    m_IOT_rq    = ((flags2 &  4) != 0);
-    m_EMT_rq    = ((flags2 &  8) != 0);
-    m_TRAPrq    = ((flags2 & 16) != 0);
+    if (flags2 &   1) m_intrq |= INTRQ_FIS;
+    if (flags2 &   2) m_intrq |= INTRQ_BPT;
+    if (flags2 &   4) m_intrq |= INTRQ_IOT;
+    if (flags2 &   8) m_intrq |= INTRQ_EMT;
+    if (flags2 &  16) m_intrq |= INTRQ_TRAP;
     m_ACLOreset = ((flags2 & 32) != 0);
     m_EVNTreset = ((flags2 & 64) != 0);
-    m_VIRQrq    = ((flags2 & 128) != 0);
+    if (flags2 & 128) m_intrq |= INTRQ_VIRQ;
     //                                              //   29    35   Reserved
 }
 
@@ -2684,7 +3020,7 @@ uint16_t CProcessor::GetWordAddr (uint8_t meth, uint8_t reg)
             uint16_t addr = GetWord(GetPC());
             SetPC(GetPC() + 2);
             addr = GetReg(reg) + addr;
-            if (!m_RPLYrq)
+            if ((m_intrq & INTRQ_RPLY) == 0)
                 return GetWord(addr);
             return addr;
         }
@@ -2729,7 +3065,7 @@ uint16_t CProcessor::GetByteAddr (uint8_t meth, uint8_t reg)
         addr = GetWord(GetPC());
         SetPC(GetPC() + 2);
         addr = GetReg(reg) + addr;
-        if (!m_RPLYrq) addr = GetWord(addr);
+        if ((m_intrq & INTRQ_RPLY) == 0) addr = GetWord(addr);
         break;
     }
 
@@ -18,38 +18,81 @@ NEONBTL. If not, see <http://www.gnu.org/licenses/>. */
 
 //////////////////////////////////////////////////////////////////////
 
+// Decoded instruction cache size, must be power of 2
+#define DECODECACHE_SIZE 4096
+
+// Default cost of the native FIS command, close to the average of the ROM routine
+#define FIS_NATIVE_TIMING 1600
+
+// Internal ticks of every instruction and interrupt in functional mode, see CProcessor::SetFixedTiming()
+#define FUNCTIONAL_TIMING 15
+
+// Lazy PSW condition codes: kind of the operation which set N/Z/V/C last, see CProcessor::SetLazyPSW()
+#define LAZYPSW_NONE    0     // N/Z/V/C bits in m_psw are up to date
+#define LAZYPSW_ADD     1     // res = a + b
+#define LAZYPSW_SUB     2     // res = a - b
+#define LAZYPSW_LOGIC   3     // N/Z by res, V = 0, C = a
+#define LAZYPSW_INC     4     // N/Z by res, V if res = 100000, C = a
+#define LAZYPSW_DEC     5     // N/Z by res, V if res = 077777, C = a
+#define LAZYPSW_BYTE    0200  // Byte operation flag
+
+// Pending interrupt requests, CProcessor::m_intrq bits; the highest bit set is taken first
+#define INTRQ_VIRQ      0x0001  // VIRQ interrupt request
+#define INTRQ_EVNT      0x0002  // Timer event interrupt pending
+#define INTRQ_HALTPIN   0x0004  // HALT pin
+#define INTRQ_ACLO      0x0008  // Power down interrupt pending
+#define INTRQ_TBIT      0x0010  // T-bit interrupt pending
+#define INTRQ_RSVD      0x0020  // Reserved instruction interrupt pending
+#define INTRQ_ILLG      0x0040  // Illegal instruction interrupt pending
+#define INTRQ_RPLY      0x0080  // Hangup interrupt pending
+#define INTRQ_FIS       0x0100  // FIS command interrupt pending
+#define INTRQ_TRAP      0x0200  // TRAP command interrupt pending
+#define INTRQ_EMT       0x0400  // EMT command interrupt pending
+#define INTRQ_IOT       0x0800  // IOT command interrupt pending
+#define INTRQ_BPT       0x1000  // BPT command interrupt pending
+#define INTRQ_HALT      0x2000  // HALT command
+#define INTRQ_STRT      0x4000  // Start interrupt pending
+#define INTRQ_COMMANDS  (INTRQ_HALT | INTRQ_BPT | INTRQ_IOT | INTRQ_EMT | INTRQ_TRAP | INTRQ_FIS)  // Set by commands
+
 // KM1801VM2 processor
 class CProcessor
 {
 public:  // Constructor / initialization
     CProcessor(CMotherboard* pBoard);
-    void        SetHALTPin(bool value) { m_haltpin = value; }
-    bool        GetHALTPin() const { return m_haltpin; }
-    bool        GetVIRQPin() const { return m_VIRQrq; }
+    void        SetHALTPin(bool value) { if (value) m_intrq |= INTRQ_HALTPIN; else m_intrq &= ~INTRQ_HALTPIN; }
+    bool        GetHALTPin() const { return (m_intrq & INTRQ_HALTPIN) != 0; }
+    bool        GetVIRQPin() const { return (m_intrq & INTRQ_VIRQ) != 0; }
     void        SetDCLOPin(bool value);
     void        SetACLOPin(bool value);
     void        MemoryError();
 
-public:
-    static void Init();  // Initialize static tables
-    static void Done();  // Release memory used for static tables
 protected:  // Statics
     typedef void ( CProcessor::*ExecuteMethodRef )();
-    static ExecuteMethodRef* m_pExecuteMethodMap;
+    static const ExecuteMethodRef m_ExecuteMethodBlocks[1024];  // By instruction >> 6, see GetExecuteMethod()
+    static const ExecuteMethodRef m_ExecuteMethods0000[64];
+    static const ExecuteMethodRef m_ExecuteMethods0200[64];
+    static ExecuteMethodRef GetExecuteMethod(uint16_t instruction);  // Find command implementation
 
 protected:  // Processor state
     uint16_t    m_internalTick;     // How many ticks waiting to the end of current instruction
-    uint16_t    m_psw;              // Processor Status Word (PSW)
+    uint64_t    m_ticks;            // Processor ticks counter, advanced by RunUntil()
+    uint64_t    m_tickTarget;       // RunUntil() target ticks value
+    uint16_t    m_psw;              // Processor Status Word (PSW); N/Z/V/C are stale while m_lazyop is set
+    uint8_t     m_lazyop;           // Operation pending to set N/Z/V/C, see LAZYPSW_Xxx
+    bool        m_lazysave;         // CPSW copied PSW at the pending operation, its N/Z/V/C are stale too
+    uint16_t    m_lazya, m_lazyb, m_lazyres;  // Operands and result of the pending operation
     uint16_t    m_R[8];             // Registers (R0..R5, R6=SP, R7=PC)
     uint16_t    m_savepc;           // CPC register
     uint16_t    m_savepsw;          // CPSW register
     bool        m_okStopped;        // "Processor stopped" flag
     bool        m_stepmode;         // Read true if it's step mode
     bool        m_buserror;         // Read true if occured bus error for implementing double bus error if needed
-    bool        m_haltpin;          // HALT pin
     bool        m_DCLOpin;          // DCLO pin
     bool        m_ACLOpin;          // ACLO pin
     bool        m_waitmode;         // WAIT
+    bool        m_okFISNative;      // Execute FADD/FSUB/FMUL/FDIV natively instead of the ROM routine
+    uint16_t    m_FIStiming;        // Ticks charged for the native FIS command
+    uint16_t    m_fixedTiming;      // Internal ticks of every instruction, 0 = use the timing tables
 
 protected:  // Current instruction processing
     uint16_t    m_instruction;      // Current instruction
@@ -60,32 +103,36 @@ protected:  // Current instruction processing
     uint8_t     m_regdest;          // Destination register number
     uint8_t     m_methdest;         // Destination address mode
     uint16_t    m_addrdest;         // Destination address
+protected:  // Decoded instruction cache, see FetchInstruction()
+    struct DecodedInstruction
+    {
+        uint32_t    key;            // RAM offset | 1, ROM offset | 0x80000001, 0 = empty entry
+        uint16_t    instruction;    // Instruction word
+        uint8_t     regsrc, methsrc, regdest, methdest;  // Operand fields
+        ExecuteMethodRef methodref; // Command implementation
+    };
+    DecodedInstruction m_decoded[DECODECACHE_SIZE];  // Direct-mapped by physical address
+    DecodedInstruction m_decodedtemp;  // Instruction fetched from I/O or EMUL area, not cached
+    DecodedInstruction* m_pdecoded;    // Current instruction
+protected:  // Polling loop detection, see CheckPollingLoop()
+    uint16_t    m_pollpc;           // Address of the backward branch at the last pass, odd = none
+    uint64_t    m_polltick;         // Ticks counter at the last pass
+    uint16_t    m_pollR[8];         // Registers at the last pass
+    uint16_t    m_pollpsw;          // PSW at the last pass
+    uint64_t    m_pollskipped;      // Ticks skipped in polling loops, for statistics
 protected:  // Interrupt processing
-    bool        m_STRTrq;           // Start interrupt pending
-    bool        m_RPLYrq;           // Hangup interrupt pending
-    bool        m_ILLGrq;           // Illegal instruction interrupt pending
-    bool        m_RSVDrq;           // Reserved instruction interrupt pending
-    bool        m_TBITrq;           // T-bit interrupt pending
-    bool        m_ACLOrq;           // Power down interrupt pending
-    bool        m_HALTrq;           // HALT command or HALT signal
-    bool        m_EVNTrq;           // Timer event interrupt pending
-    bool        m_FIS_rq;           // FIS command interrupt pending
-    bool        m_BPT_rq;           // BPT command interrupt pending
-    bool        m_IOT_rq;           // IOT command interrupt pending
-    bool        m_EMT_rq;           // EMT command interrupt pending
-    bool        m_TRAPrq;           // TRAP command interrupt pending
-    bool        m_VIRQrq;           // VIRQ interrupt request
+    uint16_t    m_intrq;            // Pending interrupt requests and HALT/VIRQ lines, see INTRQ_Xxx
     bool        m_ACLOreset;        // Power fail interrupt request reset
     bool        m_EVNTreset;        // EVNT interrupt request reset
 protected:
     CMotherboard* m_pBoard;
 
 public:  // Register control
-    uint16_t    GetPSW() const { return m_psw; }  // Get the processor status word register value
-    uint16_t    GetCPSW() const { return m_savepsw; }
-    uint8_t     GetLPSW() const { return (uint8_t)(m_psw & 0xff); }  // Get PSW lower byte
+    uint16_t    GetPSW() const;  // Get the processor status word register value
+    uint16_t    GetCPSW() const;
+    uint8_t     GetLPSW() const { return (uint8_t)(GetPSW() & 0xff); }  // Get PSW lower byte
     void        SetPSW(uint16_t word);  // Set the processor status word register value
-    void        SetCPSW(uint16_t word) { m_savepsw = word; }
+    void        SetCPSW(uint16_t word) { FlushLazyPSW(); m_savepsw = word; }
     void        SetLPSW(uint8_t byte);
     uint16_t    GetReg(int regno) const { return m_R[regno]; }  // Get register value, regno=0..7
     void        SetReg(int regno, uint16_t word);  // Set register value
@@ -100,15 +147,20 @@ public:  // Register control
 
 public:  // PSW bits control
     void        SetC(bool bFlag);
-    uint16_t    GetC() const { return (m_psw & PSW_C) != 0; }
+    uint16_t    GetC() const;
     void        SetV(bool bFlag);
-    uint16_t    GetV() const { return (m_psw & PSW_V) != 0; }
+    uint16_t    GetV() const { return (GetPSW() & PSW_V) != 0; }
     void        SetN(bool bFlag);
-    uint16_t    GetN() const { return (m_psw & PSW_N) != 0; }
+    uint16_t    GetN() const { return (GetPSW() & PSW_N) != 0; }
     void        SetZ(bool bFlag);
-    uint16_t    GetZ() const { return (m_psw & PSW_Z) != 0; }
+    uint16_t    GetZ() const { return (GetPSW() & PSW_Z) != 0; }
     void        SetHALT(bool bFlag);
     uint16_t    GetHALT() const { return (m_psw & PSW_HALT) != 0; }
+protected:  // Lazy PSW condition codes
+    // Remember the operation instead of calculating N/Z/V/C now; see LAZYPSW_Xxx for a, b, res meaning
+    void        SetLazyPSW(uint8_t op, uint16_t a, uint16_t b, uint16_t res);
+    uint8_t     GetLazyFlags() const;  // Calculate N/Z/V/C for the pending operation
+    void        FlushLazyPSW();  // Put the pending N/Z/V/C into PSW and CPSW
 
 public:  // Processor state
     // "Processor stopped" flag
@@ -121,13 +173,37 @@ public:  // Processor control
     void        SetVIRQ(bool value);
     // Execute one processor tick
     void        Execute();
+    // Execute whole instructions until the ticks counter reaches the target value
+    //   Returns false if stopped on a breakpoint
+    bool        RunUntil(uint64_t target);
+    // Stop RunUntil() earlier, when the target value is less than the current one
+    void        LimitRun(uint64_t target) { if (target < m_tickTarget) m_tickTarget = target; }
+    uint64_t    GetTicks() const { return m_ticks; }
     // Process pending interrupt requests
     bool        InterruptProcessing();
+    // Check if InterruptProcessing() would take an interrupt now
+    bool        IsInterruptPending() const;
+    uint16_t    GetInterruptMask() const;  // INTRQ_Xxx bits not masked by the current state
     // Execute next command and process interrupts
     void        CommandExecution();
     int         GetInternalTick() const { return m_internalTick; }
     void        ClearInternalTick() { m_internalTick = 0; }
     uint16_t    GetInstructionPC() const { return m_instructionpc; }  // Address of the current instruction
+    // Forget the decoded instruction at the RAM offset; called by the board on a code page write
+    bool        InvalidateDecoded(uint32_t offset)
+    {
+        DecodedInstruction* entry = m_decoded + ((offset >> 1) & (DECODECACHE_SIZE - 1));
+        if (entry->key != ((offset & ~1u) | 1)) return false;
+        entry->key = 0;
+        return true;
+    }
+    void        FlushDecoded();  // Forget all decoded instructions, on ROM/RAM reload
+    // Execute FIS commands natively at the given cost in ticks, or by the ROM routine
+    void        SetFISNative(bool okNative, uint16_t timing) { m_okFISNative = okNative; m_FIStiming = timing; }
+    // Charge every instruction the same internal ticks instead of the timing tables; 0 = exact timing
+    void        SetFixedTiming(uint16_t timing) { m_fixedTiming = timing; }
+    // Ticks skipped by the polling loop detector since the processor creation
+    uint64_t    GetPollSkippedTicks() const { return m_pollskipped; }
 
 public:  // Saving/loading emulator status (pImage addresses up to 32 bytes)
     void        SaveToImage(uint8_t* pImage) const;
@@ -136,16 +212,51 @@ public:  // Saving/loading emulator status (pImage addresses up to 32 bytes)
 protected:  // Implementation
     void        FetchInstruction();      // Read next instruction
     void        TranslateInstruction();  // Execute the instruction
+    static void DecodeInstruction(DecodedInstruction* entry, uint16_t instruction);
+    void        CheckPollingLoop();      // Called after a taken short backward branch
+    bool        IsPollingLoopPure(uint16_t address, uint16_t end) const;
+    bool        IsPollOperandStable(int meth, int reg, uint16_t& address) const;
+    void        ExecuteBlockCopy();      // Called after SOB going back to MOV (Rs)+,(Rd)+
 protected:  // Implementation - memory access
     // Read word from the bus for execution
     uint16_t    GetWordExec(uint16_t address) { return m_pBoard->GetWordExec(address, IsHaltMode()); }
-    // Read word from the bus
-    uint16_t    GetWord(uint16_t address) { return m_pBoard->GetWord(address, IsHaltMode()); }
-    void        SetWord(uint16_t address, uint16_t word) { m_pBoard->SetWord(address, IsHaltMode(), word); }
-    void        SetWordRMW(uint16_t address, uint16_t word) { m_pBoard->SetWord(address, IsHaltMode(), word, true); }
-    uint8_t     GetByte(uint16_t address) { return m_pBoard->GetByte(address, IsHaltMode()); }
-    void        SetByte(uint16_t address, uint8_t byte) { m_pBoard->SetByte(address, IsHaltMode(), byte); }
-    void        SetByteRMW(uint16_t address, uint8_t byte) { m_pBoard->SetByte(address, IsHaltMode(), byte, true); }
+    // Read word from the bus; plain RAM/ROM directly, the rest through the board
+    uint16_t    GetWord(uint16_t address, bool isRMW = false)
+    {
+        const uint8_t* p = m_pBoard->GetReadPointer(address & ~1, IsHaltMode());
+        return (p != nullptr) ? *((const uint16_t*)p) : m_pBoard->GetWord(address, IsHaltMode(), false, isRMW);
+    }
+    uint16_t    GetWordRMW(uint16_t address) { return GetWord(address, true); }
+    void        SetWord(uint16_t address, uint16_t word, bool isRMW = false)
+    {
+        uint8_t* p = m_pBoard->GetWritePointer(address & ~1, IsHaltMode());
+        if (p == nullptr)
+            m_pBoard->SetWord(address, IsHaltMode(), word, isRMW);
+        else
+        {
+            *((uint16_t*)p) = word;
+            m_pBoard->CheckCodeWrite(m_pBoard->GetRAMOffset(p));
+        }
+    }
+    void        SetWordRMW(uint16_t address, uint16_t word) { SetWord(address, word, true); }
+    uint8_t     GetByte(uint16_t address, bool isRMW = false)
+    {
+        const uint8_t* p = m_pBoard->GetReadPointer(address, IsHaltMode());
+        return (p != nullptr) ? *p : m_pBoard->GetByte(address, IsHaltMode(), isRMW);
+    }
+    uint8_t     GetByteRMW(uint16_t address) { return GetByte(address, true); }
+    void        SetByte(uint16_t address, uint8_t byte, bool isRMW = false)
+    {
+        uint8_t* p = m_pBoard->GetWritePointer(address, IsHaltMode());
+        if (p == nullptr)
+            m_pBoard->SetByte(address, IsHaltMode(), byte, isRMW);
+        else
+        {
+            *p = byte;
+            m_pBoard->CheckCodeWrite(m_pBoard->GetRAMOffset(p));
+        }
+    }
+    void        SetByteRMW(uint16_t address, uint8_t byte) { SetByte(address, byte, true); }
 
 protected:  // PSW bits calculations
     bool static CheckForNegative(uint8_t byte) { return (byte & 0200) != 0; }
@@ -182,6 +293,7 @@ protected:  // Implementation - instruction execution
     void        ExecuteSTEP ();
     void        ExecuteRSEL ();
     void        ExecuteFIS ();
+    bool        ExecuteFISNative ();
     void        ExecuteRUN ();
     void        ExecuteRTT ();
     void        ExecuteCCC ();
@@ -267,13 +379,85 @@ protected:  // Implementation - instruction execution
     void        ExecuteSUB ();
 };
 
+// Lazy PSW condition codes - implementation
+inline uint8_t CProcessor::GetLazyFlags() const
+{
+    uint16_t sign = (m_lazyop & LAZYPSW_BYTE) ? 0200 : 0100000;
+    uint16_t a = m_lazya, b = m_lazyb, res = m_lazyres;
+    uint8_t flags = 0;
+    if (res & sign) flags |= PSW_N;
+    if (res == 0) flags |= PSW_Z;
+    switch (m_lazyop & ~LAZYPSW_BYTE)
+    {
+    case LAZYPSW_ADD:
+        if ((~(a ^ b) & (res ^ b)) & sign) flags |= PSW_V;
+        if (((a & b) | ((a ^ b) & ~res)) & sign) flags |= PSW_C;
+        break;
+    case LAZYPSW_SUB:
+        if (((a ^ b) & ~(res ^ b)) & sign) flags |= PSW_V;
+        if (((~a & b) | (~(a ^ b) & res)) & sign) flags |= PSW_C;
+        break;
+    case LAZYPSW_INC:
+        if (res == sign) flags |= PSW_V;
+        flags |= (uint8_t)a;
+        break;
+    case LAZYPSW_DEC:
+        if (res == (uint16_t)(sign - 1)) flags |= PSW_V;
+        flags |= (uint8_t)a;
+        break;
+    default:  // LAZYPSW_LOGIC
+        flags |= (uint8_t)a;
+    }
+    return flags;
+}
+inline void CProcessor::SetLazyPSW(uint8_t op, uint16_t a, uint16_t b, uint16_t res)
+{
+    m_lazyop = op;  m_lazya = a;  m_lazyb = b;  m_lazyres = res;
+    // Like SetLPSW(), CPSW follows PSW when not in HALT mode with priority 6..7
+    m_lazysave = (m_psw & 0600) != 0600;
+    if (m_lazysave) m_savepsw = m_psw;
+}
+inline void CProcessor::FlushLazyPSW()
+{
+    if (m_lazyop == LAZYPSW_NONE) return;
+    uint8_t flags = GetLazyFlags();
+    m_psw = (m_psw & ~017) | flags;
+    if (m_lazysave) m_savepsw = (m_savepsw & ~017) | flags;
+    m_lazyop = LAZYPSW_NONE;
+}
+inline uint16_t CProcessor::GetPSW() const
+{
+    if (m_lazyop == LAZYPSW_NONE) return m_psw;
+    return (m_psw & ~017) | GetLazyFlags();
+}
+inline uint16_t CProcessor::GetCPSW() const
+{
+    if (m_lazyop == LAZYPSW_NONE || !m_lazysave) return m_savepsw;
+    return (m_savepsw & ~017) | GetLazyFlags();
+}
+inline uint16_t CProcessor::GetC() const
+{
+    switch (m_lazyop & ~LAZYPSW_BYTE)
+    {
+    case LAZYPSW_NONE:
+        return (m_psw & PSW_C) != 0;
+    case LAZYPSW_ADD:
+    case LAZYPSW_SUB:
+        return (GetLazyFlags() & PSW_C) != 0;
+    default:  // The operation keeps C
+        return m_lazya & PSW_C;
+    }
+}
+
 inline void CProcessor::SetPSW(uint16_t word)
 {
+    FlushLazyPSW();
     m_psw = word & 0777;
     if ((m_psw & 0600) != 0600) m_savepsw = m_psw;
 }
 inline void CProcessor::SetLPSW(uint8_t byte)
 {
+    FlushLazyPSW();
     m_psw = (m_psw & 0xFF00) | (uint16_t)byte;
     if ((m_psw & 0600) != 0600) m_savepsw = m_psw;
 }
@@ -296,33 +480,38 @@ inline void CProcessor::SetPC(uint16_t word)
 // PSW bits control - implementation
 inline void CProcessor::SetC (bool bFlag)
 {
+    FlushLazyPSW();
     if (bFlag) m_psw |= PSW_C; else m_psw &= ~PSW_C;
     if ((m_psw & 0600) != 0600) m_savepsw = m_psw;
 }
 inline void CProcessor::SetV (bool bFlag)
 {
+    FlushLazyPSW();
     if (bFlag) m_psw |= PSW_V; else m_psw &= ~PSW_V;
     if ((m_psw & 0600) != 0600) m_savepsw = m_psw;
 }
 inline void CProcessor::SetN (bool bFlag)
 {
+    FlushLazyPSW();
     if (bFlag) m_psw |= PSW_N; else m_psw &= ~PSW_N;
     if ((m_psw & 0600) != 0600) m_savepsw = m_psw;
 }
 inline void CProcessor::SetZ (bool bFlag)
 {
+    FlushLazyPSW();
     if (bFlag) m_psw |= PSW_Z; else m_psw &= ~PSW_Z;
     if ((m_psw & 0600) != 0600) m_savepsw = m_psw;
 }
 
 inline void CProcessor::SetHALT (bool bFlag)
 {
+    FlushLazyPSW();
     if (bFlag) m_psw |= PSW_HALT; else m_psw &= ~PSW_HALT;
 }
 
 inline void CProcessor::SetVIRQ(bool value)
 {
-    m_VIRQrq = value;
+    if (value) m_intrq |= INTRQ_VIRQ; else m_intrq &= ~INTRQ_VIRQ;
 }
 
 // PSW bits calculations - implementation
@@ -0,0 +1,108 @@
+﻿/*  This file is part of NEONBTL.
+    NEONBTL is free software: you can redistribute it and/or modify it under the terms
+of the GNU Lesser General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+    NEONBTL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License along with
+NEONBTL. If not, see <http://www.gnu.org/licenses/>. */
+
+// SoundSynth.cpp
+//
+
+#include "stdafx.h"
+#include "Emubase.h"
+#include <cmath>
+
+
+//////////////////////////////////////////////////////////////////////
+
+// Cutoff frequency of the band-limited step, part of the sample rate; a bit below the Nyquist frequency
+#define SOUNDSYNTH_CUTOFF  0.45
+
+CSoundSynth::CSoundSynth() :
+    m_samplerate(SOUNDSAMPLERATE), m_origin(0), m_read(0), m_shift(0), m_level(0)
+{
+    ::memset(m_buffer, 0, sizeof(m_buffer));
+
+    // Band-limited impulse: windowed sinc; the steps are integrated in ReadSample()
+    const double pi = 3.14159265358979323846;
+    const double halfwidth = SOUNDSYNTH_TAPS / 2;
+    for (int phase = 0; phase < SOUNDSYNTH_PHASES; phase++)
+    {
+        double taps[SOUNDSYNTH_TAPS];
+        double sum = 0.0;
+        for (int tap = 0; tap < SOUNDSYNTH_TAPS; tap++)
+        {
+            // Distance from the impulse centre, the impulse is delayed by halfwidth - 1 samples
+            double x = tap - (halfwidth - 1) - (double)phase / SOUNDSYNTH_PHASES;
+            double sinc = (x == 0.0) ? 2 * SOUNDSYNTH_CUTOFF : sin(2 * pi * SOUNDSYNTH_CUTOFF * x) / (pi * x);
+            double window = (fabs(x) < halfwidth) ? 0.5 + 0.5 * cos(pi * x / halfwidth) : 0.0;  // Hann window
+            taps[tap] = sinc * window;
+            sum += taps[tap];
+        }
+
+        // The taps of every phase sum up to exactly 1, so the integrated level does not drift
+        int total = 0, centre = 0;
+        for (int tap = 0; tap < SOUNDSYNTH_TAPS; tap++)
+        {
+            m_kernel[phase][tap] = (int16_t)floor(taps[tap] / sum * (1 << SOUNDSYNTH_UNITBITS) + 0.5);
+            total += m_kernel[phase][tap];
+            if (m_kernel[phase][tap] > m_kernel[phase][centre])
+                centre = tap;
+        }
+        m_kernel[phase][centre] = (int16_t)(m_kernel[phase][centre] + (1 << SOUNDSYNTH_UNITBITS) - total);
+    }
+}
+
+void CSoundSynth::Reset(uint64_t ticks, int level)
+{
+    m_origin = ticks;
+    m_read = 0;
+    m_shift = 0;
+    m_level = level << SOUNDSYNTH_UNITBITS;
+    ::memset(m_buffer, 0, sizeof(m_buffer));
+}
+
+// Samples from m_origin up to the PIT tick, 16.16 fixed point; exact, m_origin moves by whole seconds
+uint64_t CSoundSynth::GetPosition(uint64_t ticks) const
+{
+    return (ticks - m_origin) * (uint64_t)m_samplerate * 65536 / SOUNDSYNTH_TICKRATE;
+}
+
+void CSoundSynth::AddDelta(uint64_t ticks, int delta)
+{
+    uint64_t position = GetPosition(ticks);
+    uint32_t index = (uint32_t)(position >> 16) + m_shift;
+    const int16_t* kernel = m_kernel[(position >> (16 - SOUNDSYNTH_PHASEBITS)) & (SOUNDSYNTH_PHASES - 1)];
+    for (int tap = 0; tap < SOUNDSYNTH_TAPS; tap++)
+        m_buffer[(index + tap) & (SOUNDSYNTH_BUFSIZE - 1)] += delta * kernel[tap];
+}
+
+// A step at the PIT tick or later touches the samples from its position on, so the samples before are complete
+uint32_t CSoundSynth::GetSamplesReady(uint64_t ticks) const
+{
+    uint32_t complete = (uint32_t)(GetPosition(ticks) >> 16);
+    return (complete > m_read) ? complete - m_read : 0;
+}
+
+int CSoundSynth::ReadSample()
+{
+    int32_t& slot = m_buffer[(m_read + m_shift) & (SOUNDSYNTH_BUFSIZE - 1)];
+    m_level += slot;
+    slot = 0;
+
+    m_read++;
+    if (m_read >= (uint32_t)m_samplerate)  // Move the origin by one second, keeping the buffer slots
+    {
+        m_origin += SOUNDSYNTH_TICKRATE;
+        m_read -= m_samplerate;
+        m_shift += m_samplerate;
+    }
+
+    return m_level >> SOUNDSYNTH_UNITBITS;
+}
+
+
+//////////////////////////////////////////////////////////////////////
@@ -289,6 +289,118 @@ void PIT8253::Tick(uint8_t channel)
     }
 }
 
+uint32_t PIT8253::Advance(uint8_t channel, uint32_t nTicks, bool okStopOnEdge, uint32_t* pHigh)
+{
+    PIT8253_chan& chan = m_chan[channel];
+    uint32_t done = 0;
+    while (done < nTicks)
+    {
+        if (chan.gateprev == chan.gate)  // No gate edge on the next tick, try the closed form
+        {
+            uint32_t skipped = Skip(chan, nTicks - done, okStopOnEdge, pHigh);
+            if (skipped > 0)
+            {
+                done += skipped;
+                continue;
+            }
+        }
+
+        // Phase change, counter reload or output change: one tick the usual way
+        bool output = chan.output;
+        Tick(channel);
+        chan.gateprev = chan.gate;
+        done++;
+        if (chan.output && pHigh != nullptr)
+            (*pHigh)++;
+        if (okStopOnEdge && chan.output != output)
+            break;
+    }
+    return done;
+}
+
+// Closed form part of Advance(), for the gate kept at its level: skips the ticks which change nothing
+// or only count down keeping phase and output, and whole periods of modes 2 and 3.
+// Returns the ticks skipped, 0 if the next tick has to go through Tick().
+uint32_t PIT8253::Skip(PIT8253_chan& chan, uint32_t nTicks, bool okStopOnEdge, uint32_t* pHigh)
+{
+    uint8_t mode = (chan.control >> 1) & 7;
+    bool okFrozen = false;  // true = the ticks change nothing at all
+    uint32_t run = 0;  // Ticks of counting down by one
+    switch (mode)
+    {
+    case 0:
+        if (chan.phase == 0 || (chan.phase != 1 && !chan.gate))
+            okFrozen = true;
+        else if (chan.phase == 3)
+            run = nTicks;
+        else if (chan.phase == 2 && chan.value > 1)
+            run = chan.value - 1u;  // Down to 1, then the terminal count tick
+        break;
+    case 1:
+        if (chan.phase == 0 || chan.phase == 3)
+            run = nTicks;
+        else if (chan.phase == 2 && chan.value > 0)
+            run = chan.value;  // Down to 0, then the wrap tick
+        break;
+    case 2:
+        if (!chan.gate || chan.phase == 0)
+            okFrozen = chan.output;
+        else if (chan.phase == 2)
+        {
+            // After the first reload the output stays low, and the counter repeats itself every period
+            uint32_t period = (chan.count > 2) ? chan.count : 2;
+            if (!chan.output && chan.value == chan.count && nTicks >= period)
+                return nTicks - nTicks % period;
+            if (chan.value > 2)
+                run = chan.value - 2u;  // Down to 2, then the reload ticks
+        }
+        break;
+    case 3:
+        if (!chan.gate || chan.phase == 0)
+            okFrozen = chan.output;
+        else if (chan.phase == 2)
+        {
+            uint16_t half = chan.count / 2;
+            uint32_t period = (chan.count > 1) ? chan.count : 1;
+            if (chan.value == chan.count && chan.output == (chan.count > half) && nTicks >= period &&
+                (!okStopOnEdge || chan.count <= 1))
+            {
+                uint32_t periods = nTicks / period;
+                if (pHigh != nullptr)
+                    *pHigh += periods * (uint32_t)(chan.count - half);
+                return periods * period;
+            }
+            if (chan.output && chan.value > half + 1)
+                run = chan.value - 1u - half;  // Down to half + 1, output still high
+            else if (!chan.output && chan.value > 1 && chan.value <= half + 1)
+                run = chan.value - 1u;  // Down to 1, output still low
+        }
+        break;
+    case 4:
+    case 5:
+        if ((mode == 4 && !chan.gate) || chan.phase == 0)
+            okFrozen = true;
+        else if (chan.phase == 2 && chan.value > 0)
+            run = chan.value;  // Down to 0, then the strobe tick
+        break;
+    default:  // Modes 6 and 7 are not implemented
+        okFrozen = true;
+        break;
+    }
+
+    if (okFrozen)
+        run = nTicks;
+    else
+    {
+        if (run > nTicks)
+            run = nTicks;
+        chan.value = (uint16_t)(chan.value - run);
+    }
+    if (chan.output && pHigh != nullptr)
+        *pHigh += run;
+    return run;
+}
+
 
 //////////////////////////////////////////////////////////////////////
 
@@ -0,0 +1,181 @@
+﻿/*  This file is part of NEONBTL.
+    NEONBTL is free software: you can redistribute it and/or modify it under the terms
+of the GNU Lesser General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+    NEONBTL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License along with
+NEONBTL. If not, see <http://www.gnu.org/licenses/>. */
+
+// accbench.cpp : benchmark of the accuracy levels, see CMotherboard::SetAccuracy(); best of three runs.
+// The loop: the same instructions at every level, the host time per instruction.
+// With the HDD image given, also the frames of the HDD boot from the reset; the image is written back
+// as it was before every run.
+//
+// Build and run from this directory:
+//   g++ -std=c++11 -O2 -DPRODUCT -I. -o accbench accbench.cpp ../emubase/Board.cpp ../emubase/Processor.cpp
+//       ../emubase/pit8253.cpp ../emubase/Floppy.cpp ../emubase/Hard.cpp ../emubase/SoundSynth.cpp
+//   ./accbench [hdd.img [frames]]
+
+#include "stdafx.h"
+#include "../emubase/Emubase.h"
+#include <chrono>
+
+//////////////////////////////////////////////////////////////////////
+
+#define ACCBENCH_RUNS     3
+#define ACCBENCH_CODE     040000
+#define ACCBENCH_DATA     041000
+#define ACCBENCH_STACK    050000
+#define ACCBENCH_OUTER    20
+
+// The loop, USER mode: 3 + ACCBENCH_OUTER * (2 + 65535 * 6) instructions
+static const uint16_t ACCBENCH_PROGRAM[] =
+{
+    0012705, ACCBENCH_OUTER,  // MOV #ACCBENCH_OUTER, R5
+    0012701, ACCBENCH_DATA,   // MOV #ACCBENCH_DATA, R1
+    0012700, 0177777,         // 1: MOV #177777, R0
+    0011102,                  // 2: MOV (R1), R2
+    0060203,                  //    ADD R2, R3
+    0010361, 0000002,         //    MOV R3, 2(R1)
+    0005204,                  //    INC R4
+    0006303,                  //    ASL R3
+    0077007,                  //    SOB R0, 2
+    0077512,                  //    SOB R5, 1
+    0000777,                  //    BR .
+};
+#define ACCBENCH_INSTRUCTIONS  (3 + ACCBENCH_OUTER * (2 + 65535 * 6))
+#define ACCBENCH_END           (ACCBENCH_CODE + sizeof(ACCBENCH_PROGRAM) - 2)
+
+static uint8_t g_ROM[16384];
+static uint8_t* g_pHDD = nullptr;  // The HDD image as it was
+static long g_nHDDSize = 0;
+
+static bool WriteFile(const char* filename, const uint8_t* pData, long size)
+{
+    FILE* fp = fopen(filename, "wb");
+    if (fp == nullptr)
+        return false;
+    bool okWritten = fwrite(pData, 1, size, fp) == (size_t)size;
+    fclose(fp);
+    return okWritten;
+}
+
+static bool ReadHDDImage(const char* filename)
+{
+    FILE* fp = fopen(filename, "rb");
+    if (fp == nullptr)
+        return false;
+    fseek(fp, 0, SEEK_END);
+    g_nHDDSize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    g_pHDD = static_cast<uint8_t*>(::malloc(g_nHDDSize));
+    bool okRead = g_pHDD != nullptr && fread(g_pHDD, 1, g_nHDDSize, fp) == (size_t)g_nHDDSize;
+    fclose(fp);
+    return okRead;
+}
+
+static CMotherboard* CreateBoard(int accuracy, const char* hddfile)
+{
+    CMotherboard* pBoard = new CMotherboard();
+    pBoard->SetConfiguration(512);
+    pBoard->LoadROM(g_ROM);
+    pBoard->SetAccuracy(accuracy);
+    if (hddfile != nullptr && (!WriteFile(hddfile, g_pHDD, g_nHDDSize) || !pBoard->AttachHardImage(hddfile)))
+        printf("Failed to attach the HDD image %s\n", hddfile);
+    pBoard->Reset();
+    return pBoard;
+}
+
+// Seconds to run the loop; *pFrames = the frames it took
+static double RunLoop(int accuracy, int* pFrames)
+{
+    CMotherboard* pBoard = CreateBoard(accuracy, nullptr);
+    for (int i = 0; i < 300; i++)  // The ROM start
+        pBoard->SystemFrame();
+    for (size_t i = 0; i < sizeof(ACCBENCH_PROGRAM) / sizeof(ACCBENCH_PROGRAM[0]); i++)
+        pBoard->SetWord((uint16_t)(ACCBENCH_CODE + i * 2), false, ACCBENCH_PROGRAM[i]);
+    CProcessor* pCPU = pBoard->GetCPU();
+    pCPU->SetPSW(0340);
+    pCPU->SetSP(ACCBENCH_STACK);
+    pCPU->SetPC(ACCBENCH_CODE);
+
+    int nFrames = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (pCPU->GetPC() != ACCBENCH_END || pCPU->IsHaltMode())
+    {
+        pBoard->SystemFrame();
+        nFrames++;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    delete pBoard;
+    *pFrames = nFrames;
+    return elapsed.count();
+}
+
+// Seconds to run the HDD boot frames
+static double RunFrames(int accuracy, int nFrames, const char* hddfile)
+{
+    CMotherboard* pBoard = CreateBoard(accuracy, hddfile);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < nFrames; i++)
+        pBoard->SystemFrame();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    pBoard->DetachHardImage();
+    delete pBoard;
+    return elapsed.count();
+}
+
+int main(int argc, char* argv[])
+{
+    const char* hddfile = (argc > 1) ? argv[1] : nullptr;
+    int nFrames = (argc > 2) ? atoi(argv[2]) : 1000;
+
+    FILE* fpRom = fopen("../res/pk11.rom", "rb");
+    if (fpRom == nullptr || fread(g_ROM, 1, sizeof(g_ROM), fpRom) != sizeof(g_ROM))
+    {
+        printf("Failed to load the ROM file ../res/pk11.rom\n");
+        return 2;
+    }
+    fclose(fpRom);
+    if (hddfile != nullptr && !ReadHDDImage(hddfile))
+    {
+        printf("Failed to load the HDD image %s\n", hddfile);
+        return 2;
+    }
+
+    static const struct { int accuracy; const char* name; } levels[] =
+    {
+        { ACCURACY_EXACT,      "exact" },
+        { ACCURACY_FUNCTIONAL, "functional" },
+    };
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++)
+    {
+        double best = 0.0;
+        int nLoopFrames = 0;
+        for (int run = 0; run < ACCBENCH_RUNS; run++)
+        {
+            double seconds = RunLoop(levels[i].accuracy, &nLoopFrames);
+            if (run == 0 || seconds < best)
+                best = seconds;
+        }
+        printf("%-10s loop: %d instructions in %.3f s, %.1f ns per instruction, %d frames\n", levels[i].name,
+                ACCBENCH_INSTRUCTIONS, best, best * 1e9 / ACCBENCH_INSTRUCTIONS, nLoopFrames);
+
+        if (hddfile == nullptr)
+            continue;
+        for (int run = 0; run < ACCBENCH_RUNS; run++)
+        {
+            double seconds = RunFrames(levels[i].accuracy, nFrames, hddfile);
+            if (run == 0 || seconds < best)
+                best = seconds;
+        }
+        printf("%-10s HDD boot: %d frames in %.3f s, %.0f frames per second\n", levels[i].name, nFrames, best, nFrames / best);
+    }
+
+    ::free(g_pHDD);
+    return 0;
+}
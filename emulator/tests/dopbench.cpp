@@ -0,0 +1,136 @@
+﻿/*  This file is part of NEONBTL.
+    NEONBTL is free software: you can redistribute it and/or modify it under the terms
+of the GNU Lesser General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+    NEONBTL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License along with
+NEONBTL. If not, see <http://www.gnu.org/licenses/>. */
+
+// dopbench.cpp : microbenchmark of the double-operand commands by the addressing modes.
+// Every case is a USER mode loop of 8 same commands, with the pointers set again on every pass;
+// the host time per instruction, best of three runs.
+//
+// Build and run from this directory:
+//   g++ -std=c++11 -O2 -DPRODUCT -I. -o dopbench dopbench.cpp ../emubase/Board.cpp ../emubase/Processor.cpp
+//       ../emubase/pit8253.cpp ../emubase/Floppy.cpp ../emubase/Hard.cpp ../emubase/SoundSynth.cpp
+//   ./dopbench
+
+#include "stdafx.h"
+#include "../emubase/Emubase.h"
+#include <chrono>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+
+#define DOPBENCH_RUNS     3
+#define DOPBENCH_CODE     040000
+#define DOPBENCH_SOURCE   041000  // R1
+#define DOPBENCH_DEST     042000  // R2
+#define DOPBENCH_STACK    050000
+#define DOPBENCH_OUTER    4
+#define DOPBENCH_REPEAT   8       // Commands in the loop body
+
+struct DopBenchCase
+{
+    const char* name;
+    uint16_t    code[3];  // The command and its index or immediate words
+    int         words;
+};
+
+static const DopBenchCase DOPBENCH_CASES[] =
+{
+    { "MOV R3, R4",         { 0010304 },                  1 },
+    { "ADD R3, R4",         { 0060304 },                  1 },
+    { "CMP R3, R4",         { 0020304 },                  1 },
+    { "MOV #1, R3",         { 0012703, 1 },               2 },
+    { "ADD #1, R3",         { 0062703, 1 },               2 },
+    { "MOV (R1), R3",       { 0011103 },                  1 },
+    { "MOV R3, (R2)",       { 0010312 },                  1 },
+    { "MOV (R1), (R2)",     { 0011112 },                  1 },
+    { "MOV (R1)+, (R2)+",   { 0012122 },                  1 },
+    { "MOVB (R1)+, R3",     { 0112103 },                  1 },
+    { "BIC R3, (R2)",       { 0040312 },                  1 },
+    { "BIT (R1), R3",       { 0031103 },                  1 },
+    { "MOV 2(R1), 4(R2)",   { 0016162, 2, 4 },            3 },
+    { "MOV @#addr, R3",     { 0013703, DOPBENCH_SOURCE }, 2 },
+    { "SUB -(R1), R3",      { 0164103 },                  1 },
+};
+
+static uint8_t g_ROM[16384];
+
+// The loop program; *pInstructions = the instructions it runs to the BR . at the end
+static std::vector<uint16_t> MakeProgram(const DopBenchCase& testcase, uint32_t* pInstructions)
+{
+    std::vector<uint16_t> program;
+    program.push_back(0012705);  program.push_back(DOPBENCH_OUTER);   // MOV #DOPBENCH_OUTER, R5
+    size_t outer = program.size();
+    program.push_back(0012700);  program.push_back(0177777);          // 1: MOV #177777, R0
+    size_t inner = program.size();
+    program.push_back(0012701);  program.push_back(DOPBENCH_SOURCE);  // 2: MOV #DOPBENCH_SOURCE, R1
+    program.push_back(0012702);  program.push_back(DOPBENCH_DEST);    //    MOV #DOPBENCH_DEST, R2
+    for (int i = 0; i < DOPBENCH_REPEAT; i++)
+    {
+        for (int j = 0; j < testcase.words; j++)
+            program.push_back(testcase.code[j]);
+    }
+    program.push_back((uint16_t)(0077000 | (program.size() + 1 - inner)));           // SOB R0, 2
+    program.push_back((uint16_t)(0077500 | (program.size() + 1 - outer)));           // SOB R5, 1
+    program.push_back(0000777);                                                      // BR .
+
+    *pInstructions = 1 + DOPBENCH_OUTER * (2 + 65535 * (DOPBENCH_REPEAT + 3));
+    return program;
+}
+
+// Seconds to run the loop
+static double RunCase(const std::vector<uint16_t>& program)
+{
+    CMotherboard* pBoard = new CMotherboard();
+    pBoard->SetConfiguration(512);
+    pBoard->LoadROM(g_ROM);
+    pBoard->Reset();
+    for (int i = 0; i < 300; i++)  // The ROM start
+        pBoard->SystemFrame();
+    for (size_t i = 0; i < program.size(); i++)
+        pBoard->SetWord((uint16_t)(DOPBENCH_CODE + i * 2), false, program[i]);
+    CProcessor* pCPU = pBoard->GetCPU();
+    pCPU->SetPSW(0340);
+    pCPU->SetSP(DOPBENCH_STACK);
+    pCPU->SetPC(DOPBENCH_CODE);
+
+    uint16_t end = (uint16_t)(DOPBENCH_CODE + program.size() * 2 - 2);
+    auto start = std::chrono::steady_clock::now();
+    while (pCPU->GetPC() != end || pCPU->IsHaltMode())
+        pBoard->SystemFrame();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    delete pBoard;
+    return elapsed.count();
+}
+
+int main()
+{
+    FILE* fpRom = fopen("../res/pk11.rom", "rb");
+    if (fpRom == nullptr || fread(g_ROM, 1, sizeof(g_ROM), fpRom) != sizeof(g_ROM))
+    {
+        printf("Failed to load the ROM file ../res/pk11.rom\n");
+        return 2;
+    }
+    fclose(fpRom);
+
+    for (size_t i = 0; i < sizeof(DOPBENCH_CASES) / sizeof(DOPBENCH_CASES[0]); i++)
+    {
+        uint32_t nInstructions;
+        std::vector<uint16_t> program = MakeProgram(DOPBENCH_CASES[i], &nInstructions);
+        double best = 0.0;
+        for (int run = 0; run < DOPBENCH_RUNS; run++)
+        {
+            double seconds = RunCase(program);
+            if (run == 0 || seconds < best)
+                best = seconds;
+        }
+        printf("%-18s %5.1f ns per instruction\n", DOPBENCH_CASES[i].name, best * 1e9 / nInstructions);
+    }
+    return 0;
+}
@@ -0,0 +1,270 @@
+﻿/*  This file is part of NEONBTL.
+    NEONBTL is free software: you can redistribute it and/or modify it under the terms
+of the GNU Lesser General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+    NEONBTL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License along with
+NEONBTL. If not, see <http://www.gnu.org/licenses/>. */
+
+// emultest.cpp : differential test of the USER emulated register fast path against the HALT mode round trip.
+// Every command on every emulated register runs twice from the same state, with the fast path off and on.
+// Plain reads the ROM has nothing to do on should give the same registers, flags and register window
+// state in fewer ticks; all the other accesses, RMW reads and writes among them, should be the very same run.
+//
+// Build and run from this directory:
+//   g++ -std=c++11 -O2 -DPRODUCT -I. -o emultest emultest.cpp ../emubase/Board.cpp ../emubase/Processor.cpp
+//       ../emubase/pit8253.cpp ../emubase/Floppy.cpp ../emubase/Hard.cpp ../emubase/SoundSynth.cpp
+//   ./emultest [../res/pk11.rom]
+
+#include "stdafx.h"
+#include "../emubase/Emubase.h"
+
+//////////////////////////////////////////////////////////////////////
+
+// The addresses are in RAM in USER mode
+#define EMULTEST_CODE      040000  // The command, its operand word, then BR .
+#define EMULTEST_STACK     050000
+#define EMULTEST_TRAPS     042000  // Handlers for the trap vectors, BR . each
+#define EMULTEST_MAXTICKS  200000  // The longest round trip is well below
+#define EMULTEST_UNKNOWNCOUNT 8    // Registers tested with no ROM descriptor
+#define EMULTEST_IMAGESIZE (20480 + 4096 * 1024)
+#define EMULTEST_IMAGETIMER 256    // The real time clock bytes in the image, taken from the host clock
+#define EMULTEST_IMAGETIMERSIZE 32
+
+static const uint16_t EMULTEST_VECTORS[] = { 04, 010 };  // Bus error, reserved command
+
+enum EmulAccess
+{
+    EMULACCESS_READ,   // Plain read: the fast path is allowed
+    EMULACCESS_RMW,    // Read-modify-write: the read goes the HALT mode way
+    EMULACCESS_WRITE,  // Write: always the HALT mode way
+};
+
+struct EmulCommand
+{
+    const char* name;
+    uint16_t    instruction;  // Operand @#address, the other one R1 if any
+    EmulAccess  access;
+    bool        okByte;
+};
+
+static const EmulCommand EMULTEST_COMMANDS[] =
+{
+    { "MOV @#a,R1",  0013701, EMULACCESS_READ,  false },
+    { "MOVB @#a,R1", 0113701, EMULACCESS_READ,  true  },
+    { "TST @#a",     0005737, EMULACCESS_READ,  false },
+    { "TSTB @#a",    0105737, EMULACCESS_READ,  true  },
+    { "CMP @#a,R1",  0023701, EMULACCESS_READ,  false },
+    { "CMP R1,@#a",  0020137, EMULACCESS_READ,  false },
+    { "BITB R1,@#a", 0130137, EMULACCESS_READ,  true  },
+    { "ADD @#a,R1",  0063701, EMULACCESS_READ,  false },
+    { "INC @#a",     0005237, EMULACCESS_RMW,   false },
+    { "COMB @#a",    0105137, EMULACCESS_RMW,   true  },
+    { "ADD R1,@#a",  0060137, EMULACCESS_RMW,   false },
+    { "BIS R1,@#a",  0050137, EMULACCESS_RMW,   false },
+    { "BICB R1,@#a", 0140137, EMULACCESS_RMW,   true  },
+    { "ASL @#a",     0006337, EMULACCESS_RMW,   false },
+    { "SWAB @#a",    0000337, EMULACCESS_RMW,   false },
+    { "XOR R1,@#a",  0074137, EMULACCESS_RMW,   false },
+    { "CLRB @#a",    0105037, EMULACCESS_RMW,   true  },
+    { "MFPS @#a",    0106737, EMULACCESS_RMW,   true  },
+    { "MOV R1,@#a",  0010137, EMULACCESS_WRITE, false },
+    { "MOVB R1,@#a", 0110137, EMULACCESS_WRITE, true  },
+    { "CLR @#a",     0005037, EMULACCESS_WRITE, false },
+};
+
+struct EmulState
+{
+    uint16_t    reg[8];
+    uint16_t    psw;
+    uint16_t    hr[2];      // HR0 and HR1, the addresses of the emulated accesses
+    uint16_t    ppib;       // EF0 and EF1 flags
+    uint16_t    access;     // Access byte of the register block, 0 if none
+    uint64_t    ticks;
+};
+
+static CMotherboard* g_pBoard = nullptr;
+static uint8_t* g_pImage = nullptr;  // The board state every run starts from, so the board events come the same
+static uint8_t* g_pImageRom = nullptr;  // Board state after the run with the fast path off
+static uint8_t* g_pImageFast = nullptr;  // Board state after the run with the fast path on
+static uint32_t g_nCases = 0;
+static uint32_t g_nFastCases = 0;
+static uint32_t g_nFailures = 0;
+
+// The ROM descriptor of the emulated register at HALT address (register - 020000), see CMotherboard::ProcessEmulReadFast()
+static uint16_t GetDescriptor(uint16_t address)
+{
+    int addrtype;
+    return g_pBoard->GetWordView((uint16_t)((address & ~1) - 020000), true, false, &addrtype);
+}
+
+// Whether the ROM would do nothing on the read beyond the access byte update
+static bool IsReadPlain(uint16_t address)
+{
+    uint16_t descriptor = GetDescriptor(address);
+    if (descriptor == 0)
+        return false;  // Bus error
+    if ((descriptor & 0100000) == 0)
+        return true;  // Write handler only
+    int addrtype;
+    uint16_t access = g_pBoard->GetWordView(descriptor + 4, true, false, &addrtype);
+    return ((access >> 8) & 010) == 0;  // The mask byte does not ask for the reads
+}
+
+// Run the command on the emulated register from the saved state, until the CPU is back in USER mode
+// past the command with no HALT mode interrupt pending: after the round trip, or in a trap handler
+static void RunEmul(bool okFast, const EmulCommand& command, uint16_t address, EmulState* pResult, uint8_t* pImageResult)
+{
+    g_pBoard->LoadFromImage(g_pImage);
+    g_pBoard->SetEmulFastPath(okFast);
+    CProcessor* pCPU = g_pBoard->GetCPU();
+    g_pBoard->SetWord(EMULTEST_CODE, false, command.instruction);
+    g_pBoard->SetWord(EMULTEST_CODE + 2, false, address);
+    g_pBoard->SetWord(EMULTEST_CODE + 4, false, 0777);  // BR .
+    for (int i = 0; i < 8; i++)
+        pCPU->SetReg(i, (uint16_t)(0111111 * (i + 1)));
+    pCPU->SetReg(1, 0000125);
+    pCPU->SetSP(EMULTEST_STACK);
+    pCPU->SetPC(EMULTEST_CODE);
+    pCPU->SetPSW(0340);
+
+    uint64_t ticks = pCPU->GetTicks();
+    for (;;)
+    {
+        pCPU->RunUntil(pCPU->GetTicks() + 1);
+        if (pCPU->GetTicks() - ticks >= EMULTEST_MAXTICKS)
+            break;
+        if (!pCPU->IsHaltMode() && pCPU->GetPC() != EMULTEST_CODE && !pCPU->IsInterruptPending())
+            break;
+    }
+
+    for (int i = 0; i < 8; i++)
+        pResult->reg[i] = pCPU->GetReg(i);
+    pResult->psw = pCPU->GetPSW();
+    pResult->hr[0] = g_pBoard->GetPortView(0161200);
+    pResult->hr[1] = g_pBoard->GetPortView(0161202);
+    pResult->ppib = g_pBoard->GetPortView(0161032) & 3;
+    uint16_t descriptor = GetDescriptor(address);
+    int addrtype;
+    pResult->access = ((descriptor & 0100000) != 0) ? g_pBoard->GetWordView(descriptor + 4, true, false, &addrtype) & 0377 : 0;
+    pResult->ticks = pCPU->GetTicks() - ticks;
+    g_pBoard->SaveToImage(pImageResult);
+}
+
+static bool IsSameState(const EmulState& a, const EmulState& b)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        if (a.reg[i] != b.reg[i])
+            return false;
+    }
+    return a.psw == b.psw && a.hr[0] == b.hr[0] && a.hr[1] == b.hr[1] && a.ppib == b.ppib && a.access == b.access;
+}
+
+// The whole board state, but the host clock
+static bool IsSameImage()
+{
+    return memcmp(g_pImageRom, g_pImageFast, EMULTEST_IMAGETIMER) == 0 &&
+            memcmp(g_pImageRom + EMULTEST_IMAGETIMER + EMULTEST_IMAGETIMERSIZE, g_pImageFast + EMULTEST_IMAGETIMER + EMULTEST_IMAGETIMERSIZE,
+                    EMULTEST_IMAGESIZE - EMULTEST_IMAGETIMER - EMULTEST_IMAGETIMERSIZE) == 0;
+}
+
+static void PrintState(const char* title, const EmulState& state)
+{
+    printf("  %s: R0-R7", title);
+    for (int i = 0; i < 8; i++)
+        printf(" %06o", state.reg[i]);
+    printf(" PSW %06o HR %06o %06o EF %o access %03o ticks %llu\n", state.psw,
+            state.hr[0], state.hr[1], state.ppib, state.access, (unsigned long long)state.ticks);
+}
+
+static void TestCommand(const EmulCommand& command, uint16_t address)
+{
+    EmulState rom, fast;
+    RunEmul(false, command, address, &rom, g_pImageRom);
+    RunEmul(true, command, address, &fast, g_pImageFast);
+
+    g_nCases++;
+    bool okPlain = command.access == EMULACCESS_READ && IsReadPlain(address);
+    if (okPlain)  // Done inline: the same state, fewer ticks
+    {
+        if (fast.ticks < rom.ticks && IsSameState(rom, fast))
+        {
+            g_nFastCases++;
+            return;
+        }
+    }
+    else if (fast.ticks == rom.ticks && IsSameState(rom, fast) && IsSameImage())  // The very same run
+        return;
+
+    if (g_nFailures++ < 20)
+    {
+        printf("FAIL %s, a = %06o, descriptor %06o, %s\n", command.name, address, GetDescriptor(address),
+                okPlain ? "fast path expected" : "HALT mode round trip expected");
+        PrintState("HALT", rom);
+        PrintState("fast", fast);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* romfile = (argc > 1) ? argv[1] : "../res/pk11.rom";
+    static uint8_t rom[16384];
+    FILE* fpRom = fopen(romfile, "rb");
+    if (fpRom == nullptr || fread(rom, 1, sizeof(rom), fpRom) != sizeof(rom))
+    {
+        printf("Failed to load the ROM file %s\n", romfile);
+        return 2;
+    }
+    fclose(fpRom);
+
+    g_pBoard = new CMotherboard();
+    g_pBoard->SetConfiguration(512);
+    g_pBoard->LoadROM(rom);
+    g_pBoard->Reset();
+    for (int i = 0; i < 300; i++)  // The ROM sets up its register emulation
+        g_pBoard->SystemFrame();
+    for (size_t i = 0; i < sizeof(EMULTEST_VECTORS) / sizeof(EMULTEST_VECTORS[0]); i++)
+    {
+        uint16_t handler = (uint16_t)(EMULTEST_TRAPS + i * 2);
+        g_pBoard->SetWord(EMULTEST_VECTORS[i], false, handler);
+        g_pBoard->SetWord(EMULTEST_VECTORS[i] + 2, false, 0340);
+        g_pBoard->SetWord(handler, false, 0777);  // BR .
+    }
+    g_pImage = static_cast<uint8_t*>(::calloc(EMULTEST_IMAGESIZE, 1));
+    g_pImageRom = static_cast<uint8_t*>(::calloc(EMULTEST_IMAGESIZE, 1));
+    g_pImageFast = static_cast<uint8_t*>(::calloc(EMULTEST_IMAGESIZE, 1));
+    g_pBoard->SaveToImage(g_pImage);
+
+    // Every register the ROM knows, and a few unknown ones for the bus error
+    uint32_t nRegisters = 0, nUnknown = 0;
+    for (uint32_t address = 0174000; address < 0200000; address += 2)
+    {
+        uint32_t offset;
+        if (g_pBoard->TranslateAddress((uint16_t)address, false, false, &offset) != ADDRTYPE_EMUL)
+            continue;
+        if (GetDescriptor((uint16_t)address) == 0 && nUnknown++ >= EMULTEST_UNKNOWNCOUNT)
+            continue;
+        nRegisters++;
+        for (size_t i = 0; i < sizeof(EMULTEST_COMMANDS) / sizeof(EMULTEST_COMMANDS[0]); i++)
+        {
+            TestCommand(EMULTEST_COMMANDS[i], (uint16_t)address);
+            if (EMULTEST_COMMANDS[i].okByte)
+                TestCommand(EMULTEST_COMMANDS[i], (uint16_t)(address + 1));
+        }
+    }
+    if (g_nFastCases == 0)
+    {
+        printf("FAIL no command was done by the fast path\n");
+        g_nFailures++;
+    }
+
+    printf("%u registers, %u cases, %u by the fast path, %u failures\n", nRegisters, g_nCases, g_nFastCases, g_nFailures);
+    delete g_pBoard;
+    ::free(g_pImage);
+    ::free(g_pImageRom);
+    ::free(g_pImageFast);
+    return (g_nFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,323 @@
+﻿/*  This file is part of NEONBTL.
+    NEONBTL is free software: you can redistribute it and/or modify it under the terms
+of the GNU Lesser General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+    NEONBTL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License along with
+NEONBTL. If not, see <http://www.gnu.org/licenses/>. */
+
+// fistest.cpp : differential test of the native FIS commands against the ROM FIS routine.
+// Every case runs twice from the same state, by the ROM routine and natively, and the results
+// should be the same; for the cases left to the ROM routine, the whole run should be the same.
+//
+// Build and run from this directory:
+//   g++ -std=c++11 -O2 -DPRODUCT -I. -o fistest fistest.cpp ../emubase/Board.cpp ../emubase/Processor.cpp
+//       ../emubase/pit8253.cpp ../emubase/Floppy.cpp ../emubase/Hard.cpp ../emubase/SoundSynth.cpp
+//   ./fistest [../res/pk11.rom]
+
+#include "stdafx.h"
+#include "../emubase/Emubase.h"
+
+//////////////////////////////////////////////////////////////////////
+
+// The addresses are in RAM both in USER and in HALT mode
+#define FISTEST_CODE      040000  // The FIS command, then BR .
+#define FISTEST_OPERANDS  041000  // B high, B low, A high, A low
+#define FISTEST_STACK     050000
+#define FISTEST_TRAPS     042000  // Handlers for the trap vectors, BR . each
+#define FISTEST_MAXTICKS  200000  // The longest ROM routine run is well below
+#define FISTEST_NATIVETIMING  1   // Native command cost, far less than the ROM routine takes
+#define FISTEST_IMAGESIZE (20480 + 4096 * 1024)
+
+static const uint16_t FISTEST_VECTORS[] = { 04, 010, 0244 };  // Bus error, reserved command, FIS error
+
+struct FISState
+{
+    uint16_t    reg[8];
+    uint16_t    psw;
+    uint16_t    operand[4];
+    uint64_t    ticks;
+};
+
+static CMotherboard* g_pBoard = nullptr;
+static uint8_t* g_pImage = nullptr;  // The board state every run starts from, so the board events come the same
+static uint32_t g_nCases = 0;
+static uint32_t g_nFailures = 0;
+static uint32_t g_nRandom = 1;
+
+static uint16_t Random16()
+{
+    g_nRandom = g_nRandom * 1103515245 + 12345;
+    return (uint16_t)(g_nRandom >> 16);
+}
+
+// Operands address: R, or the words after the command for R7
+static uint16_t GetOperandAddress(uint16_t instruction, const FISState& start)
+{
+    int reg = instruction & 7;
+    return (reg == 7) ? (uint16_t)(FISTEST_CODE + 2) : start.reg[reg];
+}
+
+static bool IsRAMAddress(uint16_t address)
+{
+    uint32_t offset;
+    return g_pBoard->TranslateAddress(address, false, false, &offset) <= ADDRTYPE_RAM4;
+}
+
+// Run the FIS command from the state given, until the CPU leaves it in the mode it started in:
+// for the ROM routine, that is the return to the next command, or a trap handler
+static void RunFIS(bool okNative, uint16_t instruction, const FISState& start, FISState* pResult)
+{
+    g_pBoard->LoadFromImage(g_pImage);
+    CProcessor* pCPU = g_pBoard->GetCPU();
+    bool okHalt = (start.psw & 0400) != 0;
+    pCPU->SetFISNative(okNative, FISTEST_NATIVETIMING);
+    g_pBoard->SetWord(FISTEST_CODE + 2, okHalt, 0777);  // BR .
+    uint16_t address = GetOperandAddress(instruction, start);
+    for (int i = 0; i < 4; i++)
+    {
+        if (IsRAMAddress((uint16_t)(address + i * 2)))  // A write to a missing port would be a bus error
+            g_pBoard->SetWord((uint16_t)(address + i * 2), false, start.operand[i]);
+    }
+    g_pBoard->SetWord(FISTEST_CODE, okHalt, instruction);
+    for (int i = 0; i < 8; i++)
+        pCPU->SetReg(i, start.reg[i]);
+    pCPU->SetPSW(start.psw);
+
+    uint64_t ticks = pCPU->GetTicks();
+    for (;;)
+    {
+        pCPU->RunUntil(pCPU->GetTicks() + 1);
+        if (pCPU->GetTicks() - ticks >= FISTEST_MAXTICKS)
+            break;
+        if (pCPU->IsHaltMode() == okHalt && pCPU->GetPC() != FISTEST_CODE)
+            break;
+    }
+
+    for (int i = 0; i < 8; i++)
+        pResult->reg[i] = pCPU->GetReg(i);
+    pResult->psw = pCPU->GetPSW();
+    for (int i = 0; i < 4; i++)
+        pResult->operand[i] = IsRAMAddress((uint16_t)(address + i * 2)) ? g_pBoard->GetWord((uint16_t)(address + i * 2), false) : 0;
+    pResult->ticks = pCPU->GetTicks() - ticks;
+}
+
+static bool IsSameState(const FISState& a, const FISState& b, bool okTicks)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        if (a.reg[i] != b.reg[i])
+            return false;
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        if (a.operand[i] != b.operand[i])
+            return false;
+    }
+    return a.psw == b.psw && (!okTicks || a.ticks == b.ticks);
+}
+
+static void PrintState(const char* title, const FISState& state)
+{
+    printf("  %s: R0-R7", title);
+    for (int i = 0; i < 8; i++)
+        printf(" %06o", state.reg[i]);
+    printf(" PSW %06o operands %06o %06o %06o %06o ticks %llu\n", state.psw,
+            state.operand[0], state.operand[1], state.operand[2], state.operand[3], (unsigned long long)state.ticks);
+}
+
+static FISState MakeStart(uint16_t psw, int reg, uint16_t address, uint16_t bh, uint16_t bl, uint16_t ah, uint16_t al)
+{
+    FISState start;
+    for (int i = 0; i < 8; i++)
+        start.reg[i] = (uint16_t)(0111111 * (i + 1));
+    start.reg[6] = FISTEST_STACK;
+    start.reg[7] = FISTEST_CODE;
+    if (reg != 7)
+        start.reg[reg] = address;
+    start.psw = psw;
+    start.operand[0] = bh;  start.operand[1] = bl;
+    start.operand[2] = ah;  start.operand[3] = al;
+    start.ticks = 0;
+    return start;
+}
+
+// Arithmetic case: the native command should give the same result, R and flags as the ROM routine
+static void TestArithmetic(const char* group, int op, uint16_t bh, uint16_t bl, uint16_t ah, uint16_t al)
+{
+    uint16_t instruction = (uint16_t)(075000 | (op << 3));
+    FISState start = MakeStart(0340, 0, FISTEST_OPERANDS, bh, bl, ah, al);
+    FISState rom, native;
+    RunFIS(false, instruction, start, &rom);
+    RunFIS(true, instruction, start, &native);
+
+    g_nCases++;
+    bool okDone = rom.reg[7] == FISTEST_CODE + 2 && native.reg[7] == FISTEST_CODE + 2;
+    if (okDone && native.ticks < rom.ticks && IsSameState(rom, native, false))  // Fewer ticks: done natively
+        return;
+    if (g_nFailures++ < 20)
+    {
+        printf("FAIL %s: %06o, B %06o %06o, A %06o %06o\n", group, instruction, bh, bl, ah, al);
+        PrintState("ROM   ", rom);
+        PrintState("native", native);
+    }
+}
+
+// Case left to the ROM routine: the run with the native commands on should be the very same, tick by tick
+static void TestFallback(const char* group, uint16_t psw, int reg, uint16_t address)
+{
+    uint16_t instruction = (uint16_t)(075000 | reg);
+    FISState start = MakeStart(psw, reg, address, 040200, 0, 040300, 0);  // 1.0 + 1.5
+    FISState rom, native;
+    RunFIS(false, instruction, start, &rom);
+    RunFIS(true, instruction, start, &native);
+
+    g_nCases++;
+    if (IsSameState(rom, native, true))  // The ROM routine may not return with the operands in the ports
+        return;
+    if (g_nFailures++ < 20)
+    {
+        printf("FAIL %s: %06o, R%d = %06o, PSW %06o\n", group, instruction, reg, address, psw);
+        PrintState("ROM   ", rom);
+        PrintState("native", native);
+    }
+}
+
+// Floating point word pair: sign, 8-bit exponent, 23-bit mantissa without the hidden bit
+static void MakeFloat(int sign, int exponent, uint32_t mantissa, uint16_t* phigh, uint16_t* plow)
+{
+    *phigh = (uint16_t)((sign ? 0100000 : 0) | ((exponent & 0377) << 7) | ((mantissa >> 16) & 0177));
+    *plow = (uint16_t)mantissa;
+}
+
+static uint32_t RandomMantissa()
+{
+    return (((uint32_t)Random16() << 16) | Random16()) & 0x7fffff;
+}
+
+static void TestArithmeticGroups()
+{
+    static const uint32_t mantissas[] =  // Around the rounding bits and the mantissa overflow
+    {
+        0, 1, 2, 3, 0x7fffff, 0x7ffffe, 0x7ffffd, 0x400000, 0x3fffff, 0x400001, 0x000080, 0x00007f, 0x00ffff, 0x010000, 0x555555, 0x2aaaaa
+    };
+    const int nMantissas = sizeof(mantissas) / sizeof(mantissas[0]);
+    uint16_t bh, bl, ah, al;
+
+    for (int op = 0; op < 4; op++)
+    {
+        for (int i = 0; i < 2000; i++)  // Random words
+            TestArithmetic("random", op, Random16(), Random16(), Random16(), Random16());
+
+        for (int i = 0; i < nMantissas; i++)  // Rounding: close exponents, the mantissas with the low bits set or cleared
+        {
+            for (int j = 0; j < nMantissas; j++)
+            {
+                for (int diff = -3; diff <= 3; diff++)
+                {
+                    int sign = Random16() & 3;
+                    MakeFloat(sign & 1, 0200 + diff, mantissas[i], &bh, &bl);
+                    MakeFloat(sign >> 1, 0200, mantissas[j], &ah, &al);
+                    TestArithmetic("rounding", op, bh, bl, ah, al);
+                }
+            }
+        }
+
+        for (int i = 0; i < 400; i++)  // Overflow and underflow: exponents at the ends of the range
+        {
+            int expb = (i & 1) ? 0377 - (Random16() & 7) : 1 + (Random16() & 7);
+            int expa = (i & 2) ? 0377 - (Random16() & 7) : 1 + (Random16() & 7);
+            MakeFloat(Random16() & 1, expb, RandomMantissa(), &bh, &bl);
+            MakeFloat(Random16() & 1, expa, RandomMantissa(), &ah, &al);
+            TestArithmetic(expa > 0200 && expb > 0200 ? "overflow" : "underflow", op, bh, bl, ah, al);
+            if ((i & 3) == 1)  // Mid-range A: FDIV and FMUL go out of the range with one operand
+            {
+                MakeFloat(Random16() & 1, 0200 + (Random16() & 7), RandomMantissa(), &ah, &al);
+                TestArithmetic("overflow", op, bh, bl, ah, al);
+            }
+        }
+
+        for (int i = 0; i < 200; i++)  // Zero exponent: clean zero, minus zero, and non-zero mantissa bits
+        {
+            uint32_t mantissa = (i & 4) ? RandomMantissa() : 0;
+            MakeFloat((i >> 3) & 1, 0, mantissa, &bh, &bl);
+            MakeFloat(Random16() & 1, (i & 1) ? 0 : Random16() & 0377, RandomMantissa(), &ah, &al);
+            if (i & 2)
+                TestArithmetic("zero", op, ah, al, bh, bl);  // Zero is A
+            else
+                TestArithmetic(op == 3 ? "division by zero" : "zero", op, bh, bl, ah, al);
+        }
+    }
+}
+
+static void TestFallbackGroups()
+{
+    TestFallback("HALT mode", 0740, 0, FISTEST_OPERANDS);
+    TestFallback("HALT mode", 0400, 3, FISTEST_OPERANDS);
+    TestFallback("R7", 0340, 7, 0);
+    for (int reg = 0; reg < 6; reg++)
+        TestFallback("odd address", 0340, reg, FISTEST_OPERANDS + 1);
+
+    // Outside of RAM: the first operand, or only the last one, on the other side of a RAM boundary
+    int nOutside = 0;
+    for (uint32_t address = 2; address < 0200000 && nOutside < 8; address += 2)
+    {
+        bool okRAM = IsRAMAddress((uint16_t)address);
+        bool okRAMBefore = IsRAMAddress((uint16_t)(address - 2));
+        if (okRAM == okRAMBefore)
+            continue;
+        if (okRAMBefore)  // RAM ends here
+        {
+            TestFallback("outside RAM", 0340, 0, (uint16_t)(address - 2));
+            TestFallback("outside RAM", 0340, 1, (uint16_t)address);
+        }
+        else  // RAM starts here
+            TestFallback("outside RAM", 0340, 2, (uint16_t)(address - 4));
+        nOutside++;
+    }
+    if (nOutside == 0)
+    {
+        printf("FAIL outside RAM: no RAM boundary in the address space\n");
+        g_nFailures++;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* romfile = (argc > 1) ? argv[1] : "../res/pk11.rom";
+    static uint8_t rom[16384];
+    FILE* fpRom = fopen(romfile, "rb");
+    if (fpRom == nullptr || fread(rom, 1, sizeof(rom), fpRom) != sizeof(rom))
+    {
+        printf("Failed to load the ROM file %s\n", romfile);
+        return 2;
+    }
+    fclose(fpRom);
+
+    g_pBoard = new CMotherboard();
+    g_pBoard->SetConfiguration(512);
+    g_pBoard->LoadROM(rom);
+    g_pBoard->Reset();
+    for (int i = 0; i < 300; i++)  // The ROM sets up its FIS routine
+        g_pBoard->SystemFrame();
+    for (size_t i = 0; i < sizeof(FISTEST_VECTORS) / sizeof(FISTEST_VECTORS[0]); i++)
+    {
+        uint16_t handler = (uint16_t)(FISTEST_TRAPS + i * 2);
+        g_pBoard->SetWord(FISTEST_VECTORS[i], false, handler);
+        g_pBoard->SetWord(FISTEST_VECTORS[i] + 2, false, 0340);
+        g_pBoard->SetWord(handler, false, 0777);  // BR .
+    }
+    g_pImage = static_cast<uint8_t*>(::calloc(FISTEST_IMAGESIZE, 1));
+    g_pBoard->SaveToImage(g_pImage);
+
+    TestArithmeticGroups();
+    uint32_t nArithmetic = g_nCases;
+    TestFallbackGroups();
+
+    printf("%u arithmetic cases, %u fallback cases, %u failures\n", nArithmetic, g_nCases - nArithmetic, g_nFailures);
+    delete g_pBoard;
+    ::free(g_pImage);
+    return (g_nFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+﻿/*  This file is part of NEONBTL.
+    NEONBTL is free software: you can redistribute it and/or modify it under the terms
+of the GNU Lesser General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+    NEONBTL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License along with
+NEONBTL. If not, see <http://www.gnu.org/licenses/>. */
+
+// maskbench.cpp : benchmark of the RAM2/RAM4 write masks, the bit operations of CMotherboard::SetRAMWord2() etc.
+// against the pixel by pixel conditions they replaced; random words written over a 128 KB buffer.
+//
+// Build and run from this directory:
+//   g++ -std=c++11 -O2 -DPRODUCT -I. -o maskbench maskbench.cpp
+//   ./maskbench
+
+#include "stdafx.h"
+#include <chrono>
+
+//////////////////////////////////////////////////////////////////////
+
+#define MASKBENCH_WRITES  100000000
+
+static uint16_t g_RAM[65536];
+
+#if defined(_MSC_VER)
+#define MASKBENCH_NOINLINE __declspec(noinline)
+#else
+#define MASKBENCH_NOINLINE __attribute__((noinline))
+#endif
+
+MASKBENCH_NOINLINE static void SetWord2Conditions(uint32_t offset, uint16_t word)
+{
+    uint16_t* p = g_RAM + (offset & 0xffff);
+    uint16_t mask =
+        ((word & 0x0003) == 0 ? 0 : 0x0003) | ((word & 0x000C) == 0 ? 0 : 0x000C) |
+        ((word & 0x0030) == 0 ? 0 : 0x0030) | ((word & 0x00C0) == 0 ? 0 : 0x00C0) |
+        ((word & 0x0300) == 0 ? 0 : 0x0300) | ((word & 0x0C00) == 0 ? 0 : 0x0C00) |
+        ((word & 0x3000) == 0 ? 0 : 0x3000) | ((word & 0xC000) == 0 ? 0 : 0xC000);
+    *p = (word & mask) | (*p & ~mask);
+}
+MASKBENCH_NOINLINE static void SetWord2Bits(uint32_t offset, uint16_t word)
+{
+    uint16_t* p = g_RAM + (offset & 0xffff);
+    uint16_t mask = (uint16_t)((word | (word >> 1)) & 0x5555);
+    mask |= mask << 1;
+    *p = (word & mask) | (*p & ~mask);
+}
+MASKBENCH_NOINLINE static void SetWord4Conditions(uint32_t offset, uint16_t word)
+{
+    uint16_t* p = g_RAM + (offset & 0xffff);
+    uint16_t mask =
+        ((word & 0x000F) == 0 ? 0 : 0x000F) | ((word & 0x00F0) == 0 ? 0 : 0x00F0) |
+        ((word & 0x0F00) == 0 ? 0 : 0x0F00) | ((word & 0xF000) == 0 ? 0 : 0xF000);
+    *p = (word & mask) | (*p & ~mask);
+}
+MASKBENCH_NOINLINE static void SetWord4Bits(uint32_t offset, uint16_t word)
+{
+    uint16_t* p = g_RAM + (offset & 0xffff);
+    uint16_t mask = (uint16_t)(word | (word >> 1));
+    mask = (uint16_t)((mask | (mask >> 2)) & 0x1111);
+    mask *= 15;
+    *p = (word & mask) | (*p & ~mask);
+}
+
+// Nanoseconds per write
+static double Measure(void (*pfnSetWord)(uint32_t, uint16_t))
+{
+    uint32_t random = 12345;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < MASKBENCH_WRITES; i++)
+    {
+        random = random * 1664525 + 1013904223;
+        pfnSetWord(i, (uint16_t)(random >> 16));
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / MASKBENCH_WRITES;
+}
+
+int main()
+{
+    printf("RAM2: conditions %.2f ns, bit operations %.2f ns\n", Measure(SetWord2Conditions), Measure(SetWord2Bits));
+    printf("RAM4: conditions %.2f ns, bit operations %.2f ns\n", Measure(SetWord4Conditions), Measure(SetWord4Bits));
+    return 0;
+}
@@ -0,0 +1,87 @@
+﻿/*  This file is part of NEONBTL.
+    NEONBTL is free software: you can redistribute it and/or modify it under the terms
+of the GNU Lesser General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+    NEONBTL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License along with
+NEONBTL. If not, see <http://www.gnu.org/licenses/>. */
+
+// masktest.cpp : test of the RAM2/RAM4 masked writes, CMotherboard::SetRAMWord2() etc.,
+// against the pixel by pixel rule: a zero pixel keeps the pixel in RAM, a non-zero one replaces it.
+// All the words and bytes written, over a set of RAM contents.
+//
+// Build and run from this directory:
+//   g++ -std=c++11 -O2 -DPRODUCT -I. -o masktest masktest.cpp ../emubase/Board.cpp ../emubase/Processor.cpp
+//       ../emubase/pit8253.cpp ../emubase/Floppy.cpp ../emubase/Hard.cpp ../emubase/SoundSynth.cpp
+//   ./masktest
+
+#include "stdafx.h"
+#include "../emubase/Emubase.h"
+
+//////////////////////////////////////////////////////////////////////
+
+#define MASKTEST_OFFSET  0100000  // RAM offset to write to
+
+static const uint16_t MASKTEST_CONTENTS[] = { 0, 0xffff, 0x5555, 0xaaaa, 0x3333, 0xcccc, 0x0f0f, 0xf0f0, 0x1248, 0x8421, 0xa5c3 };
+
+// Pixel by pixel: bits per pixel 2 or 4
+static uint16_t MergePixels(uint16_t old, uint16_t value, int bits)
+{
+    uint16_t pixelmask = (uint16_t)((1 << bits) - 1);
+    uint16_t result = 0;
+    for (int shift = 0; shift < 16; shift += bits)
+    {
+        uint16_t pixel = (uint16_t)((value >> shift) & pixelmask);
+        if (pixel == 0)
+            pixel = (uint16_t)((old >> shift) & pixelmask);
+        result |= (uint16_t)(pixel << shift);
+    }
+    return result;
+}
+
+int main()
+{
+    CMotherboard* pBoard = new CMotherboard();
+    pBoard->SetConfiguration(512);
+
+    uint32_t nCases = 0, nFailures = 0;
+    for (size_t i = 0; i < sizeof(MASKTEST_CONTENTS) / sizeof(MASKTEST_CONTENTS[0]); i++)
+    {
+        uint16_t old = MASKTEST_CONTENTS[i];
+        for (uint32_t value = 0; value < 65536; value++)
+        {
+            for (int bits = 2; bits <= 4; bits += 2)
+            {
+                pBoard->SetRAMWord(MASKTEST_OFFSET, old);
+                if (bits == 2)
+                    pBoard->SetRAMWord2(MASKTEST_OFFSET, (uint16_t)value);
+                else
+                    pBoard->SetRAMWord4(MASKTEST_OFFSET, (uint16_t)value);
+                uint16_t expected = MergePixels(old, (uint16_t)value, bits);
+                uint16_t result = pBoard->GetRAMWord(MASKTEST_OFFSET);
+                nCases++;
+                if (result != expected && nFailures++ < 20)
+                    printf("FAIL SetRAMWord%d: RAM %06o, word %06o -> %06o, expected %06o\n", bits, old, value, result, expected);
+
+                if (value >= 256)
+                    continue;
+                pBoard->SetRAMWord(MASKTEST_OFFSET, old);
+                if (bits == 2)
+                    pBoard->SetRAMByte2(MASKTEST_OFFSET + 1, (uint8_t)value);
+                else
+                    pBoard->SetRAMByte4(MASKTEST_OFFSET + 1, (uint8_t)value);
+                expected = (uint16_t)((old & 0xff) | (MergePixels(old >> 8, (uint16_t)value, bits) << 8));
+                result = pBoard->GetRAMWord(MASKTEST_OFFSET);
+                nCases++;
+                if (result != expected && nFailures++ < 20)
+                    printf("FAIL SetRAMByte%d: RAM %06o, high byte %03o -> %06o, expected %06o\n", bits, old, value, result, expected);
+            }
+        }
+    }
+
+    printf("%u cases, %u failures\n", nCases, nFailures);
+    delete pBoard;
+    return (nFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,332 @@
+﻿/*  This file is part of NEONBTL.
+    NEONBTL is free software: you can redistribute it and/or modify it under the terms
+of the GNU Lesser General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+    NEONBTL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License along with
+NEONBTL. If not, see <http://www.gnu.org/licenses/>. */
+
+// pittest.cpp : test of PIT8253::Advance() against the same ticks by PIT8253::Tick().
+// Every mode, phase, gate and output; all the small counter values, and the big ones around
+// the half and the whole count.
+// Then the board timers, m_snd outputs driving m_snl gates, against a PIT pair ticked one by one:
+// the sound samples should be the same.
+//
+// Build and run from this directory:
+//   g++ -std=c++11 -O2 -DPRODUCT -I. -o pittest pittest.cpp ../emubase/Board.cpp ../emubase/Processor.cpp
+//       ../emubase/pit8253.cpp ../emubase/Floppy.cpp ../emubase/Hard.cpp ../emubase/SoundSynth.cpp
+//   ./pittest
+
+#include "stdafx.h"
+#include "../emubase/Emubase.h"
+
+//////////////////////////////////////////////////////////////////////
+
+// The test sets up the channel state directly: PIT8253 is a standard layout class, the channels are its only data
+static_assert(sizeof(PIT8253) == sizeof(PIT8253_chan) * 3, "PIT8253 layout");
+static PIT8253_chan& GetChannel(PIT8253& pit, uint8_t channel)
+{
+    return reinterpret_cast<PIT8253_chan*>(&pit)[channel];
+}
+
+static uint32_t g_nCases = 0;
+static uint32_t g_nFailures = 0;
+
+static bool IsSameChannel(const PIT8253_chan& a, const PIT8253_chan& b)
+{
+    return a.control == b.control && a.phase == b.phase && a.value == b.value && a.count == b.count &&
+            a.gate == b.gate && a.gateprev == b.gateprev && a.output == b.output;
+}
+
+static void PrintChannel(const char* title, const PIT8253_chan& chan)
+{
+    printf("  %s: control %03o phase %u value %u count %u gate %d/%d output %d\n", title,
+            chan.control, chan.phase, chan.value, chan.count, chan.gateprev, chan.gate, chan.output);
+}
+
+// Advance() against nTicks calls of Tick()
+static void TestCase(uint8_t channel, const PIT8253_chan& start, uint32_t nTicks, bool okStopOnEdge)
+{
+    PIT8253 fast, slow;
+    GetChannel(fast, channel) = start;
+    GetChannel(slow, channel) = start;
+
+    uint32_t highFast = 0, highSlow = 0;
+    uint32_t doneFast = fast.Advance(channel, nTicks, okStopOnEdge, &highFast);
+    uint32_t doneSlow = 0;
+    while (doneSlow < nTicks)
+    {
+        bool output = GetChannel(slow, channel).output;
+        slow.Tick();
+        doneSlow++;
+        if (GetChannel(slow, channel).output)
+            highSlow++;
+        if (okStopOnEdge && GetChannel(slow, channel).output != output)
+            break;
+    }
+
+    g_nCases++;
+    if (doneFast == doneSlow && highFast == highSlow &&
+        IsSameChannel(GetChannel(fast, channel), GetChannel(slow, channel)))
+        return;
+    if (g_nFailures++ < 20)
+    {
+        printf("FAIL channel %u, %u ticks%s: done %u/%u, high %u/%u\n", channel, nTicks,
+                okStopOnEdge ? " to the edge" : "", doneFast, doneSlow, highFast, highSlow);
+        PrintChannel("start  ", start);
+        PrintChannel("Advance", GetChannel(fast, channel));
+        PrintChannel("Tick   ", GetChannel(slow, channel));
+    }
+}
+
+// Every mode, phase, gate levels and output, for the counter values and the tick counts given
+static void TestStates(const uint16_t* counts, int nCounts, const uint16_t* values, int nValues, const uint32_t* ticks, int nTicks)
+{
+    for (int mode = 0; mode < 8; mode++)
+    {
+        for (int phase = 0; phase < 4; phase++)
+        {
+            for (int gates = 0; gates < 4; gates++)
+            {
+                for (int output = 0; output < 2; output++)
+                {
+                    for (int i = 0; i < nCounts; i++)
+                    {
+                        for (int j = 0; j < nValues; j++)
+                        {
+                            PIT8253_chan start;
+                            start.control = (uint8_t)(0x30 | (mode << 1));
+                            start.phase = (uint8_t)phase;
+                            start.count = counts[i];
+                            start.value = (values != nullptr) ? values[j] : (uint16_t)j;
+                            start.gate = (gates & 1) != 0;
+                            start.gateprev = (gates & 2) != 0;
+                            start.output = output != 0;
+                            uint8_t channel = (uint8_t)(g_nCases % 3);
+                            for (int k = 0; k < nTicks; k++)
+                            {
+                                TestCase(channel, start, ticks[k], false);
+                                TestCase(channel, start, ticks[k], true);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+#define PITTEST_CHANNEL_LEVEL  (255 * 255 / 3)  // Same as SOUND_CHANNEL_LEVEL in Board.cpp
+#define PITTEST_BOARDFRAMES    200
+#define PITTEST_STEPTICKS      20000  // CPU ticks of the accesses between the frames, the synthesizer buffer is 5 ms
+#define PITTEST_MAXSAMPLES     4096
+
+static uint32_t g_nRandom = 1;
+static uint16_t g_BoardSamples[PITTEST_MAXSAMPLES];  // Samples given out by the board in the frame
+static uint32_t g_nBoardSamples = 0;
+
+static uint16_t Random16()
+{
+    g_nRandom = g_nRandom * 1103515245 + 12345;
+    return (uint16_t)(g_nRandom >> 16);
+}
+
+static void CALLBACK BoardSoundCallback(unsigned short L, unsigned short /*R*/)
+{
+    if (g_nBoardSamples < PITTEST_MAXSAMPLES)
+        g_BoardSamples[g_nBoardSamples] = L;
+    g_nBoardSamples++;
+}
+
+static uint16_t GetSoundValue(int sample)  // The band-limited steps overshoot a bit
+{
+    return (uint16_t)(sample < 0 ? 0 : (sample > 65535 ? 65535 : sample));
+}
+
+// The PIT pair and the synthesizer the old way: every 2 MHz tick, m_snd ticks, then m_snl with the gates
+// set by m_snd outputs; the channel sound is m_snd output gated by m_snl output of the same channel
+struct PITPair
+{
+    PIT8253     snd, snl;
+    CSoundSynth synth;
+    uint64_t    ticks;  // PIT ticks done
+    bool        level[3];
+    uint16_t    samples[PITTEST_MAXSAMPLES];  // Samples complete, not compared yet
+    uint32_t    nSamples;
+
+    PITPair(int samplerate) : ticks(0), nSamples(0)
+    {
+        int total = 0;
+        for (uint8_t chan = 0; chan < 3; chan++)
+        {
+            snd.SetGate(chan, true);
+            level[chan] = snd.GetOutput(chan) && snl.GetOutput(chan);
+            if (level[chan])
+                total += PITTEST_CHANNEL_LEVEL;
+        }
+        synth.SetSampleRate(samplerate);
+        synth.Reset(0, total);
+    }
+    void UpdateLevels()
+    {
+        for (uint8_t chan = 0; chan < 3; chan++)
+        {
+            bool value = snd.GetOutput(chan) && snl.GetOutput(chan);
+            if (value == level[chan])
+                continue;
+            level[chan] = value;
+            synth.AddDelta(ticks, value ? PITTEST_CHANNEL_LEVEL : -PITTEST_CHANNEL_LEVEL);
+        }
+    }
+    void RunTo(uint64_t target)  // Take the samples every 1000 ticks, as the board does on its sound events
+    {
+        while (ticks < target)
+        {
+            snd.Tick();
+            for (uint8_t chan = 0; chan < 3; chan++)
+                snl.SetGate(chan, snd.GetOutput(chan));
+            snl.Tick();
+            ticks++;
+            UpdateLevels();
+            if (ticks % 1000 == 0 || ticks == target)
+                TakeSamples();
+        }
+    }
+    void TakeSamples()
+    {
+        for (uint32_t count = synth.GetSamplesReady(ticks); count > 0; count--)
+        {
+            int sample = synth.ReadSample();
+            if (nSamples < PITTEST_MAXSAMPLES)
+                samples[nSamples] = GetSoundValue(sample);
+            nSamples++;
+        }
+    }
+    void DropSamples(uint32_t count)
+    {
+        memmove(samples, samples + count, (nSamples - count) * sizeof(samples[0]));
+        nSamples -= count;
+    }
+};
+
+// Board timers run on demand: up to a port access, a sound event or a frame end. The CPU is stopped,
+// the test moves the CPU ticks counter and accesses the PIT ports at random points.
+static void TestBoardTimers()
+{
+    CMotherboard* pBoard = new CMotherboard();
+    CProcessor* pCPU = pBoard->GetCPU();
+    pCPU->SetDCLOPin(true);  // Stop the CPU, nothing else touches the PITs
+    pBoard->SetSoundGenCallback(BoardSoundCallback);
+    PITPair pair(pBoard->GetSoundSampleRate());
+    const uint32_t cpuTicksPerPITTick = (uint32_t)pBoard->GetCPUClockMultiplier() * 4;
+
+    uint32_t nSamples = 0, nAccesses = 0;
+    for (int frame = 0; frame < PITTEST_BOARDFRAMES; frame++)
+    {
+        g_nBoardSamples = 0;
+        uint64_t stepend = pCPU->GetTicks() + PITTEST_STEPTICKS;
+        for (;;)
+        {
+            uint16_t random = Random16();
+            uint32_t step = (random & 3) ? (Random16() & 15) + 1 : (Random16() & 4095) + 1;
+            if (pCPU->GetTicks() + step > stepend)
+                break;
+            pCPU->RunUntil(pCPU->GetTicks() + step);
+            pair.RunTo(pCPU->GetTicks() / cpuTicksPerPITTick);  // The board PITs tick on CPU ticks 4, 8, 12...
+
+            bool okSnl = (random & 0x10) != 0;
+            PIT8253& pit = okSnl ? pair.snl : pair.snd;
+            uint16_t port = okSnl ? 0161020 : 0161010;
+            uint8_t chan = (uint8_t)((random >> 5) % 3);
+            if ((random & 0x300) == 0)  // Read the counter, the board catches up first
+            {
+                pBoard->GetWord((uint16_t)(port + chan * 2), true);
+                pit.Read(chan);
+            }
+            else  // New mode and count; counts of a few ticks give many edges
+            {
+                uint8_t mode = (uint8_t)(Random16() % 6);
+                uint16_t count = (uint16_t)((Random16() & 0x400) ? (Random16() & 1023) + 1 : (Random16() & 15) + 2);
+                uint8_t control = (uint8_t)((chan << 6) | 0x30 | (mode << 1));
+                pBoard->SetWord((uint16_t)(port + 6), true, control);
+                pBoard->SetWord((uint16_t)(port + chan * 2), true, count & 0xff);
+                pBoard->SetWord((uint16_t)(port + chan * 2), true, count >> 8);
+                pit.Write(3, control);
+                pit.Write(chan, (uint8_t)(count & 0xff));
+                pit.Write(chan, (uint8_t)(count >> 8));
+                pair.UpdateLevels();  // The control word sets the output at once
+            }
+            nAccesses++;
+        }
+
+        pBoard->SystemFrame();
+        pair.RunTo(pCPU->GetTicks() / cpuTicksPerPITTick);
+
+        // The board gives out the samples on its sound events, up to 1 ms behind
+        g_nCases++;
+        bool okSame = g_nBoardSamples <= PITTEST_MAXSAMPLES && pair.nSamples <= PITTEST_MAXSAMPLES &&
+                g_nBoardSamples <= pair.nSamples && g_nBoardSamples + SOUNDSAMPLERATE / 1000 + 1 >= pair.nSamples;
+        for (uint32_t i = 0; okSame && i < g_nBoardSamples; i++)
+        {
+            if (pair.samples[i] != g_BoardSamples[i])
+            {
+                okSame = false;
+                if (g_nFailures < 20)
+                    printf("FAIL board timers, frame %d sample %u: %u, per tick %u\n", frame, i, g_BoardSamples[i], pair.samples[i]);
+            }
+        }
+        nSamples += g_nBoardSamples;
+        if (okSame)
+        {
+            pair.DropSamples(g_nBoardSamples);
+            continue;
+        }
+        if (g_nFailures++ < 20)
+            printf("FAIL board timers, frame %d: %u samples, %u per tick\n", frame, g_nBoardSamples, pair.nSamples);
+        break;
+    }
+
+    printf("%d board frames, %u PIT accesses, %u samples\n", PITTEST_BOARDFRAMES, nAccesses, nSamples);
+    delete pBoard;
+}
+
+int main()
+{
+    // Small counts: all the counter values, all the tick counts up to a few periods
+    uint16_t smallcounts[14];
+    for (int i = 0; i < 13; i++)
+        smallcounts[i] = (uint16_t)i;
+    smallcounts[13] = 65535;
+    uint32_t smallticks[40];
+    for (int i = 0; i < 40; i++)
+        smallticks[i] = (uint32_t)(i + 1);
+    TestStates(smallcounts, 14, nullptr, 14, smallticks, 40);  // Values 0..13
+    uint32_t nSmall = g_nCases;
+
+    // Big counts: the values around the half and the whole count, up to two periods and a bit
+    static const uint16_t bigcounts[] = { 31, 32, 33, 255, 256, 257, 1000, 32767, 32768, 65534, 65535 };
+    const int nBigCounts = sizeof(bigcounts) / sizeof(bigcounts[0]);
+    for (int i = 0; i < nBigCounts; i++)
+    {
+        uint16_t count = bigcounts[i];
+        uint16_t half = (uint16_t)(count / 2);
+        const uint16_t values[] =
+        {
+            0, 1, 2, 3, (uint16_t)(half - 1), half, (uint16_t)(half + 1), (uint16_t)(half + 2),
+            (uint16_t)(count - 2), (uint16_t)(count - 1), count, (uint16_t)(count + 1), (uint16_t)(count + 2), 65535
+        };
+        const uint32_t ticks[] = { 1, 2, 3, 64, 1000, (uint32_t)half + 2, (uint32_t)count * 2 + 3 };
+        TestStates(&count, 1, values, sizeof(values) / sizeof(values[0]), ticks, sizeof(ticks) / sizeof(ticks[0]));
+    }
+
+    uint32_t nBig = g_nCases - nSmall;
+
+    TestBoardTimers();
+
+    printf("%u small count cases, %u big count cases, %u failures\n", nSmall, nBig, g_nFailures);
+    return (g_nFailures == 0) ? 0 : 1;
+}
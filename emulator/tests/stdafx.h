@@ -0,0 +1,42 @@
+﻿/*  This file is part of NEONBTL.
+    NEONBTL is free software: you can redistribute it and/or modify it under the terms
+of the GNU Lesser General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+    NEONBTL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the GNU Lesser General Public License for more details.
+    You should have received a copy of the GNU Lesser General Public License along with
+NEONBTL. If not, see <http://www.gnu.org/licenses/>. */
+
+// stdafx.h : stand-in for the emulator stdafx.h, to build the emubase sources
+// into the console test programs without Windows, see the test files for the command lines
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+typedef char TCHAR;
+typedef const char* LPCTSTR;
+typedef char* LPTSTR;
+
+#define _T(x) x
+#define CALLBACK
+#define _tfopen fopen
+#define _tcscpy strcpy
+#define _tcscmp strcmp
+#define _tcslen strlen
+
+#define ASSERT(f) ((void)0)
+#define VERIFY(f) ((void)(f))
+
+// Common.h functions the emubase sources use; the tests print their own results
+inline void DebugLog(LPCTSTR) {}
+inline void DebugLogFormat(LPCTSTR, ...) {}
+inline void DebugPrintFormat(LPCTSTR, ...) {}
+inline void PrintOctalValue(TCHAR* buffer, uint16_t value) { sprintf(buffer, "%06o", value); }
+inline void PrintBinaryValue(TCHAR* buffer, uint16_t value) { for (int i = 0; i < 16; i++) buffer[i] = (value & (0100000 >> i)) ? '1' : '0'; buffer[16] = 0; }